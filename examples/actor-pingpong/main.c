@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/actor.h"
+#include "fsm/runtime.h"
+
+// pairs of actors bounce balls back and forth, the ball itself is the payload and is never
+// copied; one worker keeps both sides of a pair on the same core, two let them split
+
+enum {
+    PLAYING
+};
+
+enum {
+    BALL
+};
+
+typedef struct {
+    struct fsm_message message;
+
+    fsm_actor_t *peer;
+    uint32_t remaining;
+    uint64_t received;
+} example_data_t;
+
+typedef struct {
+    uint32_t hops;
+} ball_t;
+
+static bool trigger_ball(const void *context) {
+    return ((const example_data_t *)context)->message.event==BALL;
+}
+
+static void action_return_ball(void *context) {
+    example_data_t *data = (example_data_t *)context;
+    ball_t *ball = data->message.payload;
+
+    ball->hops++;
+    data->received++;
+
+    if(data->remaining) {
+        data->remaining--;
+
+        const bool sent = fsm_send(data->peer, BALL, ball);
+        assert(sent);
+        (void)sent;
+    }
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void setup(fsm_actor_t *actor, example_data_t *data, fsm_actor_t *peer, uint32_t remaining) {
+    *data = (example_data_t){.peer = peer, .remaining = remaining};
+    *actor = (fsm_actor_t){
+        .fsm = {
+            .context = data
+        }
+    };
+
+    fsm_add_state(&actor->fsm, PLAYING, NULL, NULL, NULL);
+
+    fsm_add_transition(&actor->fsm, PLAYING, PLAYING, trigger_ball, action_return_ball);
+}
+
+int main(int argc, char **argv) {
+    const uint32_t pairs_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 64;
+    const uint32_t rounds_num = (argc>2) ? strtoul(argv[2], NULL, 10) : 20000;
+    const uint32_t window = (argc>3) ? strtoul(argv[3], NULL, 10) : 8;
+
+    if(window>FSM_ACTOR_MAILBOX_SIZE) {
+        printf("at most %u messages in flight\n", FSM_ACTOR_MAILBOX_SIZE);
+        return 1;
+    }
+
+    fsm_actor_t *actors = aligned_alloc(FSM_CACHE_LINE_SIZE, 2*pairs_num*sizeof(fsm_actor_t));
+    example_data_t *data = malloc(2*pairs_num*sizeof(example_data_t));
+    ball_t *balls = malloc(pairs_num*window*sizeof(ball_t));
+
+    if(!actors || !data || !balls) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    printf("%u pairs, %u round trips, %u balls per pair\n", pairs_num, rounds_num, window);
+
+    for(unsigned int threads=1; threads<=2; threads++) {
+        fsm_runtime_t runtime;
+
+        if(!fsm_runtime_init(&runtime, 2*pairs_num, fsm_actor_step, NULL)) {
+            printf("out of memory\n");
+            return 1;
+        }
+
+        for(uint32_t p=0; p<pairs_num; p++) {
+            setup(&actors[2*p], &data[2*p], &actors[2*p + 1], window*rounds_num - window);
+            setup(&actors[2*p + 1], &data[2*p + 1], &actors[2*p], window*rounds_num);
+
+            fsm_actor_spawn(&actors[2*p], &runtime, PLAYING);
+            fsm_actor_spawn(&actors[2*p + 1], &runtime, PLAYING);
+        }
+
+        for(uint32_t b=0; b<pairs_num*window; b++) {
+            balls[b].hops = 0;
+        }
+
+        const uint64_t start = now_ns();
+
+        if(!fsm_runtime_start(&runtime, threads)) {
+            printf("cannot start %u workers\n", threads);
+            fsm_runtime_stop(&runtime);
+            return 1;
+        }
+
+        for(uint32_t p=0; p<pairs_num; p++) {
+            for(uint32_t b=0; b<window; b++) {
+                fsm_send(&actors[2*p + 1], BALL, &balls[p*window + b]);
+            }
+        }
+
+        fsm_runtime_wait_idle(&runtime);
+
+        const uint64_t elapsed_ns = now_ns() - start;
+
+        fsm_runtime_stop(&runtime);
+
+        uint64_t received = 0;
+        uint64_t hops = 0;
+
+        for(uint32_t a=0; a<2*pairs_num; a++) {
+            received +=data[a].received;
+        }
+
+        for(uint32_t b=0; b<pairs_num*window; b++) {
+            hops +=balls[b].hops;
+        }
+
+        printf("%u worker%s %8.2f M messages/s\n", threads, (threads>1) ? "s" : " ", received*1e3/elapsed_ns);
+
+        if(received!=hops || received!=2ull*pairs_num*window*rounds_num) {
+            printf("lost messages: %llu of %llu\n", (unsigned long long)received, 2ull*pairs_num*window*rounds_num);
+            return 1;
+        }
+    }
+
+    free(actors);
+    free(data);
+    free(balls);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fsm/fsm.h"
+#include "fsm/builder.h"
+
+// a two-state toggle and a 200-state ring with 20 transitions per state are built into one
+// static buffer, each taking exactly the bytes it needs although the ring is far beyond
+// FSM_STATE_MAX_NUM and FSM_EVENT_MAX_NUM; both are then run and checked, and machines naming
+// a state that was never added or adding one twice must not build
+
+#define RING_STATES_NUM     200
+#define RING_EVENTS_NUM     20
+
+static alignas(max_align_t) uint8_t storage[128*1024];
+
+static bool trigger_never(const void *context) {
+    (void)context;
+
+    return false;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t updates_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+    fsm_arena_t arena;
+    fsm_builder_t builder = {0};
+
+    fsm_arena_init(&arena, storage, sizeof(storage));
+
+    fsm_builder_add_state(&builder, 0, NULL, NULL, NULL);
+    fsm_builder_add_state(&builder, 1, NULL, NULL, NULL);
+    fsm_builder_add_transition(&builder, 0, 1, NULL, NULL);
+    fsm_builder_add_transition(&builder, 1, 0, NULL, NULL);
+
+    const size_t toggle_size = fsm_builder_size(&builder);
+    const struct fsm_frozen *toggle = fsm_builder_build(&builder, &arena);
+
+    fsm_builder_free(&builder);
+
+    for(uint16_t s=0; s<RING_STATES_NUM; s++) {
+        fsm_builder_add_state(&builder, s, NULL, NULL, NULL);
+    }
+
+    // the last transition of each state is the only one that fires
+    for(uint16_t s=0; s<RING_STATES_NUM; s++) {
+        for(uint16_t e=0; e<RING_EVENTS_NUM - 1; e++) {
+            fsm_builder_add_transition(&builder, s, (s + e)%RING_STATES_NUM, trigger_never, NULL);
+        }
+
+        fsm_builder_add_transition(&builder, s, (s + 1)%RING_STATES_NUM, NULL, NULL);
+    }
+
+    const size_t ring_size = fsm_builder_size(&builder);
+    const struct fsm_frozen *ring = fsm_builder_build(&builder, &arena);
+
+    // no room left for a second ring
+    const struct fsm_frozen *overflow = fsm_builder_build(&builder, &arena);
+
+    fsm_builder_free(&builder);
+
+    // a transition to an unknown id and a duplicate state, each fails and so does the build
+    fsm_builder_add_state(&builder, 0, NULL, NULL, NULL);
+
+    const bool unknown_added = fsm_builder_add_transition(&builder, 0, 7, NULL, NULL);
+    const struct fsm_frozen *unknown = fsm_builder_build(&builder, &arena);
+
+    fsm_builder_free(&builder);
+
+    fsm_builder_add_state(&builder, 0, NULL, NULL, NULL);
+
+    const bool duplicate_added = fsm_builder_add_state(&builder, 0, NULL, NULL, NULL);
+    const struct fsm_frozen *duplicate = fsm_builder_build(&builder, &arena);
+
+    fsm_builder_free(&builder);
+
+    if(unknown_added || unknown || duplicate_added || duplicate) {
+        printf("a bad machine was accepted: unknown id %d/%p, duplicate state %d/%p\n", unknown_added,
+            (const void *)unknown, duplicate_added, (const void *)duplicate);
+        return 1;
+    }
+
+    if(!toggle || !ring || overflow) {
+        printf("arena of %zu bytes: toggle %p, ring %p, overflow %p\n", sizeof(storage), (const void *)toggle,
+            (const void *)ring, (const void *)overflow);
+        return 1;
+    }
+
+    printf("toggle %6zu bytes\n", toggle_size);
+    printf("ring   %6zu bytes (%u states, %u transitions)\n", ring_size, RING_STATES_NUM, RING_STATES_NUM*RING_EVENTS_NUM);
+    printf("fsm_t  %6zu bytes (at most %u states, %u transitions each)\n", sizeof(fsm_t), FSM_STATE_MAX_NUM, FSM_EVENT_MAX_NUM);
+    printf("arena  %6zu of %zu bytes used\n", arena.used, arena.size);
+
+    fsm_instance_t toggle_instance;
+    fsm_instance_t ring_instance;
+
+    fsm_instance_start(&toggle_instance, toggle, NULL, 0);
+    fsm_instance_start(&ring_instance, ring, NULL, 0);
+
+    for(uint32_t i=0; i<updates_num; i++) {
+        fsm_instance_update(&toggle_instance);
+        fsm_instance_update(&ring_instance);
+    }
+
+    const uint8_t toggle_state = toggle->cold[toggle_instance.index].id;
+    const uint8_t ring_state = ring->cold[ring_instance.index].id;
+
+    printf("after %u updates: toggle in %u, ring in %u\n", updates_num, toggle_state, ring_state);
+
+    return (toggle_state!=updates_num%2 || ring_state!=updates_num%RING_STATES_NUM) ? 1 : 0;
+}
@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fsm/fsm.h"
+#include "fsm/combine.h"
+#include "fsm/message.h"
+
+// one hot machine fed by many threads: flat combining against a mutex around fsm_update()
+// and against a lock-free queue drained by a dedicated thread; every delivered event also
+// updates lines of a shared ledger, the data a combiner keeps in its own cache while a mutex
+// moves it to every thread in turn; threads do some private work between dispatches; events
+// per combining pass stay near one unless threads really overlap, which takes at least as
+// many cores as threads and a handler long enough for events to pile up while it runs; an
+// untimed run then holds every combiner until the other threads have published, so passes
+// serve many threads at once and every event delivered for another thread is checked
+
+#define QUEUE_SIZE      1024
+#define LEDGER_LINES    64
+
+enum {
+    LIGHT_ON,
+    LIGHT_OFF
+};
+
+enum {
+    TOGGLE
+};
+
+typedef struct {
+    struct fsm_message message;
+    uint64_t toggles;
+
+    // lines_per_event of these are updated per event
+    _Alignas(64) uint64_t ledger[LEDGER_LINES][8];
+    uint32_t lines_per_event;
+
+    // piled up run only
+    const fsm_combine_t *combine;
+    unsigned int threads;
+} example_data_t;
+
+struct queue_cell {
+    _Atomic uint32_t sequence;
+    uint16_t event;
+};
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t tail;
+    _Alignas(64) uint32_t head;
+    struct queue_cell cells[QUEUE_SIZE];
+} queue_t;
+
+typedef struct {
+    fsm_t *fsm;
+    fsm_combine_t *combine;
+    pthread_mutex_t *lock;
+    queue_t *queue;
+    uint32_t events_num;
+    uint32_t think;
+} worker_t;
+
+static bool trigger_toggle(const void *context) {
+    return ((const example_data_t *)context)->message.event==TOGGLE;
+}
+
+static void action_count(void *context) {
+    example_data_t *data = context;
+
+    for(uint32_t i=0; i<data->lines_per_event; i++) {
+        data->ledger[(data->toggles*7 + i)%LEDGER_LINES][i%8]++;
+    }
+
+    data->toggles++;
+}
+
+static unsigned int pending_num(const example_data_t *data) {
+    unsigned int pending = 0;
+
+    for(unsigned int i=0; i<data->threads; i++) {
+        pending +=atomic_load_explicit(&data->combine->slots[i].pending, memory_order_acquire);
+    }
+
+    return pending;
+}
+
+// an event that is the only one pending waits a little for the other threads to publish, so
+// the passes that follow serve them all
+static void deliver_piled(fsm_t *fsm, const struct fsm_message *message) {
+    example_data_t *data = fsm->context;
+
+    if(pending_num(data)==1) {
+        for(unsigned int yields=0; yields<data->threads && pending_num(data)<data->threads; yields++) {
+            sched_yield();
+        }
+    }
+
+    data->message = *message;
+    fsm_update(fsm);
+    fsm_execute(fsm);
+}
+
+// private work between two dispatches, kept from being optimized away
+static uint32_t think(uint32_t seed, uint32_t steps) {
+    for(uint32_t i=0; i<steps; i++) {
+        seed ^=seed << 13;
+        seed ^=seed >> 17;
+        seed ^=seed << 5;
+    }
+
+    return seed;
+}
+
+static volatile uint32_t thought;
+
+static void deliver(fsm_t *fsm, uint16_t event) {
+    ((example_data_t *)fsm->context)->message.event = event;
+    fsm_update(fsm);
+    fsm_execute(fsm);
+}
+
+static void * run_combine(void *arg) {
+    worker_t *worker = arg;
+    const uint16_t slot = fsm_combine_register(worker->combine);
+    uint32_t seed = slot + 1;
+
+    for(uint32_t i=0; i<worker->events_num; i++) {
+        seed = think(seed, worker->think);
+        fsm_combine_dispatch(worker->combine, slot, TOGGLE, NULL);
+    }
+
+    thought = seed;
+
+    return NULL;
+}
+
+static void * run_mutex(void *arg) {
+    worker_t *worker = arg;
+    uint32_t seed = 1;
+
+    for(uint32_t i=0; i<worker->events_num; i++) {
+        seed = think(seed, worker->think);
+        pthread_mutex_lock(worker->lock);
+        deliver(worker->fsm, TOGGLE);
+        pthread_mutex_unlock(worker->lock);
+    }
+
+    thought = seed;
+
+    return NULL;
+}
+
+static void * run_queue(void *arg) {
+    worker_t *worker = arg;
+    queue_t *queue = worker->queue;
+    uint32_t seed = 1;
+
+    for(uint32_t i=0; i<worker->events_num; i++) {
+        seed = think(seed, worker->think);
+
+        uint32_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        struct queue_cell *cell;
+
+        for(;;) {
+            cell = &queue->cells[position%QUEUE_SIZE];
+
+            const int32_t difference = (int32_t)(atomic_load_explicit(&cell->sequence, memory_order_acquire) - position);
+
+            if(difference==0 && atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+
+            if(difference<0) {
+                sched_yield();
+            }
+
+            if(difference) {
+                position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+            }
+        }
+
+        cell->event = TOGGLE;
+        atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    }
+
+    thought = seed;
+
+    return NULL;
+}
+
+static void drain_queue(worker_t *worker, uint64_t total) {
+    queue_t *queue = worker->queue;
+
+    for(uint64_t i=0; i<total;) {
+        struct queue_cell *cell = &queue->cells[queue->head%QUEUE_SIZE];
+
+        if(atomic_load_explicit(&cell->sequence, memory_order_acquire)!=queue->head + 1) {
+            sched_yield();
+            continue;
+        }
+
+        deliver(worker->fsm, cell->event);
+        atomic_store_explicit(&cell->sequence, queue->head + QUEUE_SIZE, memory_order_release);
+        queue->head++;
+        i++;
+    }
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void setup(fsm_t *fsm, example_data_t *data, uint32_t lines_per_event) {
+    *data = (example_data_t){.lines_per_event = lines_per_event};
+    *fsm = (fsm_t){
+        .context = data
+    };
+
+    fsm_add_state(fsm, LIGHT_ON,    NULL, NULL, NULL);
+    fsm_add_state(fsm, LIGHT_OFF,   NULL, NULL, NULL);
+
+    fsm_add_transition(fsm, LIGHT_ON,   LIGHT_OFF,  trigger_toggle, action_count);
+    fsm_add_transition(fsm, LIGHT_OFF,  LIGHT_ON,   trigger_toggle, action_count);
+
+    fsm_start(fsm, LIGHT_OFF);
+}
+
+static bool report(const char *name, uint64_t elapsed_ns, const fsm_t *fsm, uint64_t total) {
+    const example_data_t *data = fsm->context;
+
+    printf("%-8s %8.2f M events/s\n", name, total*1e3/elapsed_ns);
+
+    if(data->toggles!=total || fsm->current->id!=((total & 1) ? LIGHT_ON : LIGHT_OFF)) {
+        printf("%s: %llu of %llu events delivered\n", name, (unsigned long long)data->toggles, (unsigned long long)total);
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const unsigned int threads = (argc>1) ? strtoul(argv[1], NULL, 10) : 8;
+    const uint32_t events_num = (argc>2) ? strtoul(argv[2], NULL, 10) : 200000;
+    const uint32_t lines_per_event = (argc>3) ? strtoul(argv[3], NULL, 10) : 16;
+    const uint32_t think_steps = (argc>4) ? strtoul(argv[4], NULL, 10) : 16;
+    const uint64_t total = (uint64_t)threads*events_num;
+
+    if(threads>FSM_COMBINE_SLOT_NUM) {
+        printf("at most %u threads\n", FSM_COMBINE_SLOT_NUM);
+        return 1;
+    }
+
+    pthread_t thread[FSM_COMBINE_SLOT_NUM];
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    static fsm_combine_t combine;
+    static queue_t queue;
+    static example_data_t data;
+    fsm_t fsm;
+
+    worker_t worker = {
+        .fsm = &fsm,
+        .combine = &combine,
+        .lock = &lock,
+        .queue = &queue,
+        .events_num = events_num,
+        .think = think_steps
+    };
+
+    void *(*bodies[])(void *) = {run_combine, run_mutex, run_queue};
+    const char *names[] = {"combine", "mutex", "queue"};
+
+    printf("%u threads on %ld cpus, %u events each, %u ledger lines per event, %u think steps between events\n",
+        threads, cpus, events_num, lines_per_event, think_steps);
+
+    for(int b=0; b<3; b++) {
+        setup(&fsm, &data, lines_per_event);
+        fsm_combine_init(&combine, &fsm, NULL);
+
+        atomic_init(&queue.tail, 0);
+        queue.head = 0;
+
+        for(uint32_t i=0; i<QUEUE_SIZE; i++) {
+            atomic_init(&queue.cells[i].sequence, i);
+        }
+
+        const uint64_t start = now_ns();
+
+        for(unsigned int i=0; i<threads; i++) {
+            pthread_create(&thread[i], NULL, bodies[b], &worker);
+        }
+
+        if(bodies[b]==run_queue) {
+            drain_queue(&worker, total);
+        }
+
+        for(unsigned int i=0; i<threads; i++) {
+            pthread_join(thread[i], NULL);
+        }
+
+        if(!report(names[b], now_ns() - start, &fsm, total)) {
+            return 1;
+        }
+
+        if(bodies[b]==run_combine) {
+            printf("%8s %8.2f events per combining pass%s\n", "", (double)combine.delivered/combine.passes,
+                (cpus<2) ? ", one cpu: threads only overlap when one is preempted" : "");
+        }
+    }
+
+    // a twentieth of the events, every pile-up costs a few yields
+    worker.events_num = (events_num>=20) ? events_num/20 : 1;
+
+    const uint64_t piled_total = (uint64_t)threads*worker.events_num;
+
+    setup(&fsm, &data, lines_per_event);
+    fsm_combine_init(&combine, &fsm, deliver_piled);
+    data.combine = &combine;
+    data.threads = threads;
+
+    for(unsigned int i=0; i<threads; i++) {
+        pthread_create(&thread[i], NULL, run_combine, &worker);
+    }
+
+    for(unsigned int i=0; i<threads; i++) {
+        pthread_join(thread[i], NULL);
+    }
+
+    const example_data_t *piled = fsm.context;
+
+    printf("piled    %8.2f events per combining pass, not timed\n", (double)combine.delivered/combine.passes);
+
+    if(piled->toggles!=piled_total || fsm.current->id!=((piled_total & 1) ? LIGHT_ON : LIGHT_OFF)) {
+        printf("piled: %llu of %llu events delivered\n", (unsigned long long)piled->toggles,
+            (unsigned long long)piled_total);
+        return 1;
+    }
+
+    return 0;
+}
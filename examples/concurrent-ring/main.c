@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/atomic.h"
+
+// every thread hammers one ring machine whose transitions always fire, through the
+// CAS-committed concurrent mode and through fsm_update() behind a mutex; every committed
+// transition must run exactly one exit and one enter, and exit(S) must come after enter(S)
+// with no other callback in between; the ordering runs yield inside exit so racing
+// transitions get their chance, the timed runs do not and are compared per commit, most
+// concurrent attempts lose to the transition in flight and commit nothing
+
+#define STATES_NUM  8
+#define OUTSIDE     (-1)
+
+typedef struct {
+    atomic_uint_fast64_t enters;
+    atomic_uint_fast64_t exits;
+
+    // state whose enter ran and whose exit did not yet, OUTSIDE between exit and enter
+    atomic_int inside;
+    atomic_uint_fast64_t out_of_order;
+
+    // ordering runs only
+    bool yield;
+} example_data_t;
+
+typedef struct {
+    fsm_atomic_t *atomic;
+    fsm_t *fsm;
+    pthread_mutex_t *lock;
+    uint32_t updates_num;
+    uint64_t commits;
+} worker_t;
+
+static void enter_state(example_data_t *data, int state) {
+    int expected = OUTSIDE;
+
+    if(!atomic_compare_exchange_strong(&data->inside, &expected, state)) {
+        atomic_fetch_add_explicit(&data->out_of_order, 1, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&data->enters, 1, memory_order_relaxed);
+}
+
+// yields in the middle of ordering runs so a transition racing this one gets the chance to
+// run its callbacks
+static void exit_state(example_data_t *data, int state) {
+    int expected = state;
+
+    if(data->yield) {
+        sched_yield();
+    }
+
+    if(!atomic_compare_exchange_strong(&data->inside, &expected, OUTSIDE)) {
+        atomic_fetch_add_explicit(&data->out_of_order, 1, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&data->exits, 1, memory_order_relaxed);
+}
+
+#define STATE_CALLBACKS(s) \
+    static void enter_##s(void *context) { enter_state(context, s); } \
+    static void exit_##s(void *context) { exit_state(context, s); }
+
+STATE_CALLBACKS(0)
+STATE_CALLBACKS(1)
+STATE_CALLBACKS(2)
+STATE_CALLBACKS(3)
+STATE_CALLBACKS(4)
+STATE_CALLBACKS(5)
+STATE_CALLBACKS(6)
+STATE_CALLBACKS(7)
+
+static const fsm_callback_t enters[STATES_NUM] = {enter_0, enter_1, enter_2, enter_3, enter_4, enter_5, enter_6, enter_7};
+static const fsm_callback_t exits[STATES_NUM] = {exit_0, exit_1, exit_2, exit_3, exit_4, exit_5, exit_6, exit_7};
+
+static void * run_atomic(void *arg) {
+    worker_t *worker = arg;
+
+    for(uint32_t i=0; i<worker->updates_num; i++) {
+        worker->commits +=fsm_atomic_update(worker->atomic);
+    }
+
+    return NULL;
+}
+
+static void * run_locked(void *arg) {
+    worker_t *worker = arg;
+
+    for(uint32_t i=0; i<worker->updates_num; i++) {
+        pthread_mutex_lock(worker->lock);
+        fsm_update(worker->fsm);
+        pthread_mutex_unlock(worker->lock);
+        worker->commits++;
+    }
+
+    return NULL;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void setup(fsm_t *fsm, example_data_t *data, bool yield) {
+    data->yield = yield;
+    atomic_init(&data->enters, 0);
+    atomic_init(&data->exits, 0);
+    atomic_init(&data->inside, OUTSIDE);
+    atomic_init(&data->out_of_order, 0);
+
+    *fsm = (fsm_t){
+        .context = data
+    };
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_state(fsm, s, enters[s], NULL, exits[s]);
+    }
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_transition(fsm, s, (s + 1)%STATES_NUM, NULL, NULL);
+    }
+
+    fsm_start(fsm, 0);
+    atomic_store(&data->enters, 0);
+}
+
+// returns the elapsed ns
+static uint64_t run(void *(*body)(void *), worker_t *template, unsigned int threads, uint64_t *commits) {
+    pthread_t thread[threads];
+    worker_t workers[threads];
+
+    *commits = 0;
+
+    const uint64_t start = now_ns();
+
+    for(unsigned int i=0; i<threads; i++) {
+        workers[i] = *template;
+        pthread_create(&thread[i], NULL, body, &workers[i]);
+    }
+
+    for(unsigned int i=0; i<threads; i++) {
+        pthread_join(thread[i], NULL);
+        *commits +=workers[i].commits;
+    }
+
+    return now_ns() - start;
+}
+
+// every commit ran one exit and one enter, in order, and the machine is where they lead
+static bool check(const char *name, example_data_t *data, uint64_t commits, uint16_t index) {
+    if(atomic_load(&data->enters)!=commits || atomic_load(&data->exits)!=commits || index!=commits%STATES_NUM
+        || atomic_load(&data->out_of_order)) {
+        printf("%s: %llu enters, %llu exits for %llu commits, %llu out of order\n", name,
+            (unsigned long long)atomic_load(&data->enters), (unsigned long long)atomic_load(&data->exits),
+            (unsigned long long)commits, (unsigned long long)atomic_load(&data->out_of_order));
+        return false;
+    }
+
+    return true;
+}
+
+// ordering run and timed run of the concurrent mode
+static int check_atomic(unsigned int threads, uint32_t updates_num) {
+    fsm_t fsm;
+    example_data_t data;
+    fsm_atomic_t atomic;
+    uint64_t commits;
+
+    for(int yield=1; yield>=0; yield--) {
+        setup(&fsm, &data, yield);
+        fsm_atomic_init(&atomic, &fsm);
+
+        const uint64_t elapsed_ns = run(run_atomic, &(worker_t){.atomic = &atomic, .updates_num = updates_num}, threads,
+            &commits);
+
+        if(!check(yield ? "atomic ordering" : "atomic", &data, commits, FSM_ATOMIC_INDEX(atomic_load(&atomic.current)))) {
+            return 1;
+        }
+
+        if(!yield) {
+            printf("atomic %8.2f ns/commit  %6.2f M commits/s  %llu commits of %llu attempts\n",
+                (double)elapsed_ns/commits, commits*1e3/elapsed_ns, (unsigned long long)commits,
+                (unsigned long long)threads*updates_num);
+        }
+    }
+
+    return 0;
+}
+
+static int check_locked(unsigned int threads, uint32_t updates_num) {
+    fsm_t fsm;
+    example_data_t data;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    uint64_t commits;
+
+    for(int yield=1; yield>=0; yield--) {
+        setup(&fsm, &data, yield);
+
+        const uint64_t elapsed_ns = run(run_locked, &(worker_t){.fsm = &fsm, .lock = &lock, .updates_num = updates_num},
+            threads, &commits);
+
+        if(!check(yield ? "mutex ordering" : "mutex", &data, commits, fsm.current - fsm.states)) {
+            return 1;
+        }
+
+        if(!yield) {
+            printf("mutex  %8.2f ns/commit  %6.2f M commits/s  %llu commits of %llu attempts\n",
+                (double)elapsed_ns/commits, commits*1e3/elapsed_ns, (unsigned long long)commits,
+                (unsigned long long)threads*updates_num);
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int threads = (argc>1) ? strtoul(argv[1], NULL, 10) : 4;
+    const uint32_t updates_num = (argc>2) ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    printf("%u threads, %u updates each\n", threads, updates_num);
+
+    if(check_atomic(threads, updates_num) || check_locked(threads, updates_num)) {
+        return 1;
+    }
+
+    printf("callbacks match commits\n");
+
+    return 0;
+}
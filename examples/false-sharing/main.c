@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+
+// one frozen ring machine is shared by an array of instances, thread t updates instances
+// t, t + threads, ... so neighbours belong to different threads; packed instances put several
+// of them on one cache line, fsm_instance_t gives each its own
+
+#define STATES_NUM      8
+#define INSTANCES_NUM   64
+
+typedef struct {
+    const struct fsm_frozen *frozen;
+    void *context;
+    fsm_index_t index;
+} packed_instance_t;
+
+typedef struct {
+    packed_instance_t *packed;
+    fsm_instance_t *aligned;
+    unsigned int first;
+    unsigned int threads;
+    uint32_t rounds;
+} worker_t;
+
+static void * run_packed(void *arg) {
+    worker_t *worker = arg;
+
+    for(uint32_t r=0; r<worker->rounds; r++) {
+        for(unsigned int i=worker->first; i<INSTANCES_NUM; i +=worker->threads) {
+            packed_instance_t *instance = &worker->packed[i];
+
+            fsm_frozen_update(instance->frozen, &instance->index, instance->context);
+        }
+    }
+
+    return NULL;
+}
+
+static void * run_aligned(void *arg) {
+    worker_t *worker = arg;
+
+    for(uint32_t r=0; r<worker->rounds; r++) {
+        for(unsigned int i=worker->first; i<INSTANCES_NUM; i +=worker->threads) {
+            fsm_instance_update(&worker->aligned[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static double run(const char *name, void *(*body)(void *), worker_t *template) {
+    pthread_t thread[template->threads];
+    worker_t workers[template->threads];
+
+    const uint64_t start = now_ns();
+
+    for(unsigned int i=0; i<template->threads; i++) {
+        workers[i] = *template;
+        workers[i].first = i;
+        pthread_create(&thread[i], NULL, body, &workers[i]);
+    }
+
+    for(unsigned int i=0; i<template->threads; i++) {
+        pthread_join(thread[i], NULL);
+    }
+
+    const double ns = (double)(now_ns() - start)/((uint64_t)INSTANCES_NUM*template->rounds);
+
+    printf("%-8s %8.2f ns/update\n", name, ns);
+
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int threads = (argc>1) ? strtoul(argv[1], NULL, 10) : 4;
+    const uint32_t rounds = (argc>2) ? strtoul(argv[2], NULL, 10) : 200000;
+
+    static fsm_t fsm;
+    static packed_instance_t packed[INSTANCES_NUM];
+    static fsm_instance_t aligned[INSTANCES_NUM];
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_state(&fsm, s, NULL, NULL, NULL);
+    }
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_transition(&fsm, s, (s + 1)%STATES_NUM, NULL, NULL);
+    }
+
+    const size_t size = fsm_freeze(&fsm, NULL, 0);
+    void *frozen = malloc(size);
+
+    fsm_freeze(&fsm, frozen, size);
+
+    for(unsigned int i=0; i<INSTANCES_NUM; i++) {
+        packed[i].frozen = fsm.frozen;
+        packed[i].context = NULL;
+        packed[i].index = fsm_frozen_start(fsm.frozen, NULL, 0);
+        fsm_instance_start(&aligned[i], fsm.frozen, NULL, 0);
+    }
+
+    printf("%u threads, %u instances, %zu vs %zu bytes each\n", threads, INSTANCES_NUM, sizeof(packed_instance_t),
+        sizeof(fsm_instance_t));
+
+    const double slow = run("packed", run_packed, &(worker_t){.packed = packed, .threads = threads, .rounds = rounds});
+    const double fast = run("aligned", run_aligned, &(worker_t){.aligned = aligned, .threads = threads, .rounds = rounds});
+
+    printf("speedup %.2fx\n", slow/fast);
+
+    for(unsigned int i=0; i<INSTANCES_NUM; i++) {
+        if(packed[i].index!=aligned[i].index) {
+            printf("instance %u diverged\n", i);
+            return 1;
+        }
+    }
+
+    free(frozen);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fsm/dfa.h"
+
+// "event 0 came depth events ago" run by fsm_nfa and by the lazy DFA over a long event
+// stream; fsm_dfa_dispatch() is compared after every event and fsm_dfa_feed() at the end of
+// every chunk, both on the full set of active NFA states; at SMALL_DEPTH the 2^depth reachable
+// subsets fit the DFA cache, it stops missing once warm and beats NFA stepping, at
+// LARGE_DEPTH they are far more than it holds, it flushes and falls back to NFA stepping
+
+#define SMALL_DEPTH 5
+#define LARGE_DEPTH 12
+#define EVENTS_NUM  FSM_NFA_EVENT_MAX_NUM
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static const fsm_nfa_set_t * dfa_set(const fsm_dfa_t *dfa) {
+    return (dfa->current==FSM_DFA_NONE) ? &dfa->set : &dfa->states[dfa->current].set;
+}
+
+static bool same(const fsm_dfa_t *dfa, const fsm_nfa_t *nfa) {
+    return !memcmp(dfa_set(dfa), &nfa->active, sizeof(fsm_nfa_set_t))
+        && fsm_dfa_accepts(dfa)==fsm_nfa_accepts(nfa);
+}
+
+static void print_stats(const char *name, const fsm_dfa_t *dfa, uint64_t elapsed_ns, size_t events_num) {
+    printf("%-9s %8.2f ns/event  %llu hits %llu misses %llu flushes %llu fallback steps\n", name,
+        (double)elapsed_ns/events_num, (unsigned long long)dfa->hits, (unsigned long long)dfa->misses,
+        (unsigned long long)dfa->flushes, (unsigned long long)dfa->fallback_steps);
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// state 0 waits on every event and guesses on event 0, the guess advances one state per event
+static void build(fsm_nfa_t *nfa, uint16_t depth) {
+    for(uint8_t e=0; e<EVENTS_NUM; e++) {
+        fsm_nfa_add_transition(nfa, 0, 0, e);
+
+        for(uint16_t s=1; s<depth; s++) {
+            fsm_nfa_add_transition(nfa, s, s + 1, e);
+        }
+    }
+
+    fsm_nfa_add_transition(nfa, 0, 1, 0);
+    fsm_nfa_set_accepting(nfa, depth);
+
+    fsm_nfa_compile(nfa);
+}
+
+// returns nonzero when the lazy DFA and fsm_nfa disagree, the counters do not add up or the
+// cache flushed other than expected
+static int check(const char *name, fsm_nfa_t *nfa, const uint8_t *events, size_t events_num, bool flushes) {
+    static fsm_dfa_t dfa;
+
+    printf("%s: %u states, %u events, %u cached DFA states, %zu events fed\n", name, nfa->states_num, EVENTS_NUM,
+        FSM_DFA_CACHE_NUM, events_num);
+
+    fsm_nfa_start(nfa, 0);
+
+    uint64_t start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        fsm_nfa_dispatch(nfa, events[i]);
+    }
+    const uint64_t nfa_ns = now_ns() - start;
+
+    printf("%-9s %8.2f ns/event\n", "fsm_nfa", (double)nfa_ns/events_num);
+
+    // lockstep, every event
+    fsm_nfa_start(nfa, 0);
+    fsm_dfa_start(&dfa, nfa, 0);
+
+    for(size_t i=0; i<events_num; i++) {
+        fsm_nfa_dispatch(nfa, events[i]);
+        fsm_dfa_dispatch(&dfa, events[i]);
+
+        if(!same(&dfa, nfa)) {
+            printf("dispatch differs from fsm_nfa after event %zu\n", i);
+            return 1;
+        }
+    }
+
+    // timed, chunks of random length checked at their ends
+    fsm_nfa_start(nfa, 0);
+    fsm_dfa_start(&dfa, nfa, 0);
+
+    uint64_t dfa_ns = 0;
+
+    for(size_t offset=0; offset<events_num;) {
+        size_t chunk = 1 + random_next()%4096;
+
+        if(chunk>events_num - offset) {
+            chunk = events_num - offset;
+        }
+
+        start = now_ns();
+        fsm_dfa_feed(&dfa, &events[offset], chunk);
+        dfa_ns +=now_ns() - start;
+
+        for(size_t i=offset; i<offset + chunk; i++) {
+            fsm_nfa_dispatch(nfa, events[i]);
+        }
+
+        offset +=chunk;
+
+        if(!same(&dfa, nfa)) {
+            printf("feed differs from fsm_nfa after event %zu\n", offset - 1);
+            return 1;
+        }
+    }
+
+    print_stats("fsm_dfa", &dfa, dfa_ns, events_num);
+    printf("%-9s %8.3f%% hits, x%.2f against fsm_nfa\n", "", 100.0*dfa.hits/events_num, (double)nfa_ns/dfa_ns);
+
+    if(dfa.hits + dfa.misses + dfa.fallback_steps!=events_num) {
+        printf("counters do not add up\n");
+        return 1;
+    }
+
+    if(flushes && !dfa.flushes) {
+        printf("the cache never flushed, the check did not cover it\n");
+        return 1;
+    }
+
+    if(!flushes && dfa.flushes) {
+        printf("the working set should fit the cache but it flushed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const size_t events_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    static fsm_nfa_t small, large;
+
+    build(&small, SMALL_DEPTH);
+    build(&large, LARGE_DEPTH);
+
+    uint8_t *events = malloc(events_num);
+
+    if(!events) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    // uniform events, every subset of the small machine comes up but there are only 2^SMALL_DEPTH
+    for(size_t i=0; i<events_num; i++) {
+        events[i] = random_next()%EVENTS_NUM;
+    }
+
+    int result = check("fits", &small, events, events_num, (1u << SMALL_DEPTH)>FSM_DFA_CACHE_NUM);
+
+    // quiet stretches with no event 0 stay in a few cached subsets, busy ones walk through many
+    for(size_t i=0; i<events_num;) {
+        const bool busy = random_next()%2;
+        size_t stretch = 1 + random_next()%100000;
+
+        for(; stretch && i<events_num; stretch--, i++) {
+            events[i] = busy ? random_next()%EVENTS_NUM : 1 + random_next()%(EVENTS_NUM - 1);
+        }
+    }
+
+    result |=check("thrash", &large, events, events_num, true);
+
+    free(events);
+
+    if(result) {
+        return 1;
+    }
+
+    printf("lazy DFA matches fsm_nfa\n");
+
+    return 0;
+}
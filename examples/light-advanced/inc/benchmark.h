@@ -0,0 +1,16 @@
+/**
+ * @file benchmark.h
+ * @author Eryk Możdżeń
+ * @brief Replay of recorded keystrokes with per-event latency statistics
+ * @date 2026-10-19
+ */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "fsm/fsm.h"
+
+int benchmark_replay(fsm_t *, const char *, unsigned int);
+int benchmark_freeze(fsm_t *, const char *, unsigned int, void **);
+
+#endif
@@ -1,5 +1,5 @@
 /**
- * @file states.h
+ * @file data.h
  * @author Eryk Możdżeń
  * @brief User data
  * @date 2021-12-26
@@ -8,8 +8,11 @@
 #ifndef __DATA_H__
 #define __DATA_H__
 
+#include <stdbool.h>
+
 typedef struct {
     char input;
+    bool quiet;
 } CustomUserData_t;
 
-#endif
\ No newline at end of file
+#endif
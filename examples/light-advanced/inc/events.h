@@ -9,14 +9,9 @@
 #define __EVENTS_H__
 
 #include "data.h"
-#include <stdint.h>
+#include <stdbool.h>
 
-typedef enum {
-    EVENT_ON,
-    EVENT_OFF
-} LightEvent_t;
+bool trigger_turn_on_event(const void *);
+bool trigger_turn_off_event(const void *);
 
-uint8_t get_turn_on_event(void *);
-uint8_t get_turn_off_event(void *);
-
-#endif
\ No newline at end of file
+#endif
@@ -9,7 +9,7 @@
 #include <sys/select.h>
 #include <termios.h>
 
-struct termios orig_termios;
+extern struct termios orig_termios;
 
 void reset_terminal_mode();
 void set_conio_terminal_mode();
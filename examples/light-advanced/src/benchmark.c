@@ -0,0 +1,239 @@
+/**
+ * @file benchmark.c
+ * @author Eryk Możdżeń
+ * @brief Replay of recorded keystrokes with per-event latency statistics
+ * @date 2026-10-19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "benchmark.h"
+#include "data.h"
+#include "states.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int compare(const void *a, const void *b) {
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+
+    return (x>y) - (x<y);
+}
+
+static uint8_t current_state(const fsm_t *fsm) {
+    return fsm->frozen ? fsm->frozen->cold[fsm->index].id : fsm->current->id;
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t num, double p) {
+    return sorted[(size_t)(p*(num - 1))];
+}
+
+// keys without line breaks and spaces, 1 when the file cannot be read or holds none
+static int load_keys(const char *path, char **keys_out, size_t *keys_num_out) {
+    FILE *file = fopen(path, "r");
+    if(!file) {
+        perror(path);
+        return 1;
+    }
+
+    char *keys = NULL;
+    size_t keys_num = 0;
+    size_t keys_cap = 0;
+
+    for(int c=fgetc(file); c!=EOF; c=fgetc(file)) {
+        if(c=='\n' || c=='\r' || c==' ') {
+            continue;
+        }
+
+        if(keys_num==keys_cap) {
+            keys_cap = keys_cap ? 2*keys_cap : 256;
+
+            char *grown = realloc(keys, keys_cap);
+
+            if(!grown) {
+                perror("realloc");
+                free(keys);
+                fclose(file);
+                return 1;
+            }
+
+            keys = grown;
+        }
+
+        keys[keys_num++] = (char)c;
+    }
+
+    fclose(file);
+
+    if(!keys_num) {
+        fprintf(stderr, "%s: no keystrokes recorded\n", path);
+        free(keys);
+        return 1;
+    }
+
+    *keys_out = keys;
+    *keys_num_out = keys_num;
+
+    return 0;
+}
+
+// fastest of a few batches of fsm_update() alone, one clock read per batch so the timer
+// does not drown the update; counts the transitions of the last batch
+static double time_updates(fsm_t *fsm, const char *keys, size_t keys_num, size_t events_num, size_t *transitions) {
+    CustomUserData_t *data = (CustomUserData_t *)fsm->context;
+    double best = 0;
+
+    data->quiet = true;
+
+    for(int batch=0; batch<5; batch++) {
+        const uint8_t initial = current_state(fsm);
+
+        fsm_start(fsm, initial);
+        *transitions = 0;
+
+        const uint64_t start = now_ns();
+
+        for(size_t i=0; i<events_num; i++) {
+            data->input = keys[i%keys_num];
+            *transitions +=fsm_update(fsm);
+        }
+
+        const double ns = (double)(now_ns() - start)/events_num;
+
+        if(!batch || ns<best) {
+            best = ns;
+        }
+
+        fsm_start(fsm, initial);
+    }
+
+    data->quiet = false;
+
+    return best;
+}
+
+// ns per fsm_update() on the same machine and keys before and after fsm_freeze(), the frozen
+// block is left in *frozen for the caller to free once the machine is no longer used
+int benchmark_freeze(fsm_t *fsm, const char *path, unsigned int iterations, void **frozen) {
+    char *keys;
+    size_t keys_num;
+
+    if(load_keys(path, &keys, &keys_num)) {
+        return 1;
+    }
+
+    const size_t events_num = keys_num*iterations;
+    size_t before_transitions;
+    size_t after_transitions;
+
+    const double before = time_updates(fsm, keys, keys_num, events_num, &before_transitions);
+
+    const size_t size = fsm_freeze(fsm, NULL, 0);
+
+    *frozen = malloc(size);
+
+    if(!*frozen) {
+        perror("malloc");
+        free(keys);
+        return 1;
+    }
+
+    fsm_freeze(fsm, *frozen, size);
+
+    const double after = time_updates(fsm, keys, keys_num, events_num, &after_transitions);
+
+    free(keys);
+
+    printf("frozen: %zu bytes instead of %zu\n", size, sizeof(fsm->states));
+    printf("fsm_update: %.2f ns before freezing, %.2f ns after, %+.2f ns (%+.1f%%)\n", before, after, after - before,
+        100.0*(after - before)/before);
+
+    if(before_transitions!=after_transitions) {
+        fprintf(stderr, "%zu transitions before freezing, %zu after\n", before_transitions, after_transitions);
+        return 1;
+    }
+
+    return 0;
+}
+
+// every recorded key is one event: update and execute, timed together; the transitions taken
+// and the final state are checked against the light's rules ('1' turns on, '2' turns off)
+int benchmark_replay(fsm_t *fsm, const char *path, unsigned int iterations) {
+    CustomUserData_t *data = (CustomUserData_t *)fsm->context;
+    char *keys;
+    size_t keys_num;
+
+    if(load_keys(path, &keys, &keys_num)) {
+        return 1;
+    }
+
+    const size_t events_num = keys_num*iterations;
+    uint64_t *latency = malloc(events_num*sizeof(uint64_t));
+
+    if(!latency) {
+        perror("malloc");
+        free(keys);
+        return 1;
+    }
+
+    uint8_t expected_state = current_state(fsm);
+    size_t expected_transitions = 0;
+    size_t transitions = 0;
+
+    data->quiet = true;
+
+    for(size_t i=0; i<events_num; i++) {
+        data->input = keys[i%keys_num];
+
+        const uint64_t start = now_ns();
+        transitions +=fsm_update(fsm);
+        fsm_execute(fsm);
+        latency[i] = now_ns() - start;
+
+        if((expected_state==STATE_OFF && data->input=='1') || (expected_state==STATE_ON && data->input=='2')) {
+            expected_state = (expected_state==STATE_ON) ? STATE_OFF : STATE_ON;
+            expected_transitions++;
+        }
+    }
+
+    data->quiet = false;
+
+    qsort(latency, events_num, sizeof(uint64_t), compare);
+
+    uint64_t total = 0;
+    for(size_t i=0; i<events_num; i++) {
+        total +=latency[i];
+    }
+
+    printf("events: %zu (%zu keys x %u)\n", events_num, keys_num, iterations);
+    printf("mean:   %.1f ns\n", (double)total/events_num);
+    printf("p50:    %lu ns\n", (unsigned long)percentile(latency, events_num, 0.50));
+    printf("p90:    %lu ns\n", (unsigned long)percentile(latency, events_num, 0.90));
+    printf("p99:    %lu ns\n", (unsigned long)percentile(latency, events_num, 0.99));
+    printf("p99.9:  %lu ns\n", (unsigned long)percentile(latency, events_num, 0.999));
+    printf("max:    %lu ns\n", (unsigned long)latency[events_num - 1]);
+
+    free(latency);
+    free(keys);
+
+    if(transitions!=expected_transitions || current_state(fsm)!=expected_state) {
+        fprintf(stderr, "%zu transitions ending in state %u, expected %zu ending in %u\n", transitions,
+            current_state(fsm), expected_transitions, expected_state);
+        return 1;
+    }
+
+    printf("transitions: %zu, final state matches\n", transitions);
+
+    return 0;
+}
@@ -7,12 +7,12 @@
 
 #include "events.h"
 
-// get functions for event definitions
-// must returns uint8_t and takes void* argument
-uint8_t get_turn_on_event(void *data) {
-    return ((CustomUserData_t *)data)->input=='1';
+// trigger functions for transition definitions
+// must return bool and take const void* argument
+bool trigger_turn_on_event(const void *data) {
+    return ((const CustomUserData_t *)data)->input=='1';
 }
 
-uint8_t get_turn_off_event(void *data) {
-    return ((CustomUserData_t *)data)->input=='2';
-}
\ No newline at end of file
+bool trigger_turn_off_event(const void *data) {
+    return ((const CustomUserData_t *)data)->input=='2';
+}
@@ -5,55 +5,91 @@
  * @date 2021-12-26
  */
 
-#include "finite_state_machine.h"
+#include "fsm/fsm.h"
+#include "fsm/loop.h"
 
 #include "data.h"
 #include "states.h"
 #include "events.h"
+#include "benchmark.h"
 
-#include "non_block.h"  // kbhit, getch
-#include <unistd.h>     // usleep
+#include "non_block.h"  // getch
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main() {
-    
-    set_conio_terminal_mode();
+static fsm_loop_t loop;
 
-    // user data
-    CustomUserData_t data = {'q'};
+bool read_input(void *data, int fd) {
+    (void)fd;
+
+    const int c = getch();
+
+    if(c<0) {
+        fsm_loop_stop(&loop);
+        return false;
+    }
+
+    ((CustomUserData_t *)data)->input = c;
+
+    // loop unit user click 'x' on the keyboard
+    if(c=='x') {
+        fsm_loop_stop(&loop);
+    }
 
-    FiniteStateMachine_t state_machine;
+    return true;
+}
 
-    // init state machine, link user input
-    FiniteStateMachine_Init(&state_machine, &data);
+int main(int argc, char **argv) {
 
-    // define states end events
-    FiniteStateMachine_DefineState(&state_machine, (State_t){STATE_ON,    &enter_turn_on_state,   &execute_turn_on_state,     &exit_turn_on_state});
-    FiniteStateMachine_DefineState(&state_machine, (State_t){STATE_OFF,   &enter_turn_off_state,  &execute_turn_off_state,    &exit_turn_off_state});
+    // user data
+    CustomUserData_t data = {'q', argc>1};
+
+    // link user input
+    fsm_t state_machine = {
+        .context = &data
+    };
 
-    FiniteStateMachine_DefineEvent(&state_machine, (Event_t){EVENT_ON,    &get_turn_on_event  });
-    FiniteStateMachine_DefineEvent(&state_machine, (Event_t){EVENT_OFF,   &get_turn_off_event });
+    // define states
+    fsm_add_state(&state_machine, STATE_ON,    enter_turn_on_state,    execute_turn_on_state,    exit_turn_on_state);
+    fsm_add_state(&state_machine, STATE_OFF,   enter_turn_off_state,   execute_turn_off_state,   exit_turn_off_state);
 
     // define state transitions
-    FiniteStateMachine_DefineTransition(&state_machine, STATE_ON, STATE_OFF, EVENT_OFF);  // if is in STATE_ON and EVENT_OFF occurres, change state to STATE_OFF
-    FiniteStateMachine_DefineTransition(&state_machine, STATE_OFF, STATE_ON, EVENT_ON);   // if is in STATE_OFF and EVENT_ON occurres, change state to STATE_ON
+    fsm_add_transition(&state_machine, STATE_ON, STATE_OFF, trigger_turn_off_event, NULL);  // if is in STATE_ON and '2' is pressed, change state to STATE_OFF
+    fsm_add_transition(&state_machine, STATE_OFF, STATE_ON, trigger_turn_on_event, NULL);   // if is in STATE_OFF and '1' is pressed, change state to STATE_ON
 
     // begin from initial state
-    FiniteStateMachine_Start(&state_machine, STATE_OFF);
+    fsm_start(&state_machine, STATE_OFF);
 
-    // loop unit user click 'x' on the keyboard
-    while(data.input!='x') {
-        if(kbhit())
-            data.input = getch();
+    // replay recorded keystrokes instead of reading the keyboard
+    if(argc>1) {
+        const unsigned int iterations = (argc>2) ? (unsigned int)atoi(argv[2]) : 1;
+
+        // optionally run on the compact read-only form, compared with the same updates before
+        void *frozen = NULL;
+
+        if(argc>3 && !strcmp(argv[3], "frozen")) {
+            if(benchmark_freeze(&state_machine, argv[1], iterations ? iterations : 1, &frozen)) {
+                free(frozen);
+                return 1;
+            }
+        }
 
-        FiniteStateMachine_Update(&state_machine);
+        const int result = benchmark_replay(&state_machine, argv[1], iterations ? iterations : 1);
 
-        usleep(200000);
+        free(frozen);
+
+        return result;
     }
 
-    // free memory
-    FiniteStateMachine_Deinit(&state_machine);
-    
+    set_conio_terminal_mode();
+
+    // wait for keyboard, no polling
+    loop.fsm = &state_machine;
+    fsm_loop_add_source(&loop, 0, read_input);
+    const int result = fsm_loop_run(&loop);
+
     reset_terminal_mode();
 
-    return 0;
-}
\ No newline at end of file
+    return result ? 1 : 0;
+}
@@ -2,6 +2,8 @@
 
 #include "non_block.h"
 
+struct termios orig_termios;
+
 void reset_terminal_mode()
 {
     tcsetattr(0, TCSANOW, &orig_termios);
@@ -34,8 +36,9 @@ int getch()
 {
     int r;
     unsigned char c;
-    if ((r = read(0, &c, sizeof(c))) < 0) {
-        return r;
+    /* end of input counts as an error, read leaves c untouched then */
+    if ((r = read(0, &c, sizeof(c))) <= 0) {
+        return -1;
     } else {
         return c;
     }
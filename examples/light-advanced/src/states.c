@@ -11,25 +11,31 @@
 // must returns void and takes void* argument
 
 void enter_turn_on_state(void *data) {
-    printf("Enter on state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Enter on state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
 
 void execute_turn_on_state(void *data) {
-    printf("Light is shining\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Light is shining\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
 
 void exit_turn_on_state(void *data) {
-    printf("Exit on state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Exit on state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
 
 void enter_turn_off_state(void *data) {
-    printf("Enter off state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Enter off state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
 
 void execute_turn_off_state(void *data) {
-    printf("Light is not shining\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Light is not shining\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
 
 void exit_turn_off_state(void *data) {
-    printf("Exit off state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+    if(!((CustomUserData_t *)data)->quiet)
+        printf("Exit off state\n\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "light_fsm.h"
+#include "session_fsm.h"
+
+// same machines driven by the fsm.c interpreter and by the fsmc output,
+// both must produce the same callback trace and report the same transitions
+
+typedef struct {
+    char input;
+    uint32_t trace;
+} example_data_t;
+
+static void record(void *context, uint32_t tag) {
+    example_data_t *data = (example_data_t *)context;
+
+    data->trace = data->trace*31 + tag;
+}
+
+void enter_turn_on_state(void *context)     { record(context, 1); }
+void execute_turn_on_state(void *context)   { record(context, 2); }
+void exit_turn_on_state(void *context)      { record(context, 3); }
+void enter_turn_off_state(void *context)    { record(context, 4); }
+void execute_turn_off_state(void *context)  { record(context, 5); }
+void exit_turn_off_state(void *context)     { record(context, 6); }
+
+bool trigger_turn_on_event(const void *context) {
+    return ((const example_data_t *)context)->input=='1';
+}
+
+bool trigger_turn_off_event(const void *context) {
+    return ((const example_data_t *)context)->input=='2';
+}
+
+void enter_idle(void *context)              { record(context, 11); }
+void exit_idle(void *context)               { record(context, 12); }
+void enter_connecting(void *context)        { record(context, 13); }
+void execute_connecting(void *context)      { record(context, 14); }
+void enter_active(void *context)            { record(context, 15); }
+void execute_active(void *context)          { record(context, 16); }
+void exit_active(void *context)             { record(context, 17); }
+void enter_closed(void *context)            { record(context, 18); }
+void action_open(void *context)             { record(context, 19); }
+void action_connected(void *context)        { record(context, 20); }
+void action_data(void *context)             { record(context, 21); }
+void action_close(void *context)            { record(context, 22); }
+void action_closed(void *context)           { record(context, 23); }
+
+bool on_open(const void *context)   { return ((const example_data_t *)context)->input=='o'; }
+bool on_ok(const void *context)     { return ((const example_data_t *)context)->input=='k'; }
+bool on_fail(const void *context)   { return ((const example_data_t *)context)->input=='f'; }
+bool on_data(const void *context)   { return ((const example_data_t *)context)->input=='d'; }
+bool on_close(const void *context)  { return ((const example_data_t *)context)->input=='c'; }
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static int check_session(size_t events_num) {
+    example_data_t interpreted_data = {'q', 0};
+    example_data_t generated_data = {'q', 0};
+    uint32_t seed = 7;
+
+    fsm_t interpreted = {
+        .context = &interpreted_data
+    };
+
+    fsm_add_state(&interpreted, SESSION_IDLE,          enter_idle,         NULL,               exit_idle);
+    fsm_add_state(&interpreted, SESSION_CONNECTING,    enter_connecting,   execute_connecting, NULL);
+    fsm_add_state(&interpreted, SESSION_ACTIVE,        enter_active,       execute_active,     exit_active);
+    fsm_add_state(&interpreted, SESSION_CLOSING,       NULL,               NULL,               NULL);
+    fsm_add_state(&interpreted, SESSION_CLOSED,        enter_closed,       NULL,               NULL);
+
+    fsm_add_transition(&interpreted, SESSION_IDLE,         SESSION_CONNECTING, on_open,    action_open);
+    fsm_add_transition(&interpreted, SESSION_CONNECTING,   SESSION_ACTIVE,     on_ok,      action_connected);
+    fsm_add_transition(&interpreted, SESSION_CONNECTING,   SESSION_CLOSING,    on_fail,    NULL);
+    fsm_add_transition(&interpreted, SESSION_ACTIVE,       SESSION_ACTIVE,     on_data,    action_data);
+    fsm_add_transition(&interpreted, SESSION_ACTIVE,       SESSION_CLOSING,    on_close,   action_close);
+    fsm_add_transition(&interpreted, SESSION_CLOSING,      SESSION_CLOSED,     NULL,       action_closed);
+    fsm_add_transition(&interpreted, SESSION_CLOSING,      SESSION_IDLE,       on_open,    NULL);
+    fsm_add_transition(&interpreted, SESSION_CLOSED,       SESSION_IDLE,       on_open,    action_open);
+
+    session_t generated = {
+        .context = &generated_data
+    };
+
+    fsm_start(&interpreted, SESSION_IDLE);
+    session_start(&generated, SESSION_IDLE);
+
+    bool diverged = false;
+
+    for(size_t i=0; i<events_num && !diverged; i++) {
+        seed = seed*1103515245 + 12345;
+
+        interpreted_data.input = generated_data.input = "okfdcqdo"[(seed>>16)%8];
+
+        const bool interpreted_taken = fsm_update(&interpreted);
+        fsm_execute(&interpreted);
+        const bool generated_taken = session_update(&generated);
+        session_execute(&generated);
+
+        diverged = interpreted_data.trace!=generated_data.trace || interpreted.current->id!=generated.current
+            || interpreted_taken!=generated_taken;
+    }
+
+    if(diverged) {
+        printf("session traces differ\n");
+        return 1;
+    }
+
+    printf("traces match\n");
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const size_t events_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    char *inputs = malloc(events_num);
+    uint32_t seed = 1;
+
+    if(!inputs) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for(size_t i=0; i<events_num; i++) {
+        seed = seed*1103515245 + 12345;
+        inputs[i] = "1122q"[(seed>>16)%5];
+    }
+
+    example_data_t interpreted_data = {'q', 0};
+    example_data_t generated_data = {'q', 0};
+
+    fsm_t interpreted = {
+        .context = &interpreted_data
+    };
+
+    fsm_add_state(&interpreted, LIGHT_ON,    enter_turn_on_state,    execute_turn_on_state,    exit_turn_on_state);
+    fsm_add_state(&interpreted, LIGHT_OFF,   enter_turn_off_state,   execute_turn_off_state,   exit_turn_off_state);
+
+    fsm_add_transition(&interpreted, LIGHT_ON,   LIGHT_OFF,  trigger_turn_off_event, NULL);
+    fsm_add_transition(&interpreted, LIGHT_OFF,  LIGHT_ON,   trigger_turn_on_event,  NULL);
+
+    light_t generated = {
+        .context = &generated_data
+    };
+
+    fsm_start(&interpreted, LIGHT_OFF);
+    light_start(&generated, LIGHT_OFF);
+
+    size_t interpreted_taken = 0, generated_taken = 0;
+
+    uint64_t start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        interpreted_data.input = inputs[i];
+        interpreted_taken +=fsm_update(&interpreted);
+        fsm_execute(&interpreted);
+    }
+    const uint64_t interpreted_ns = now_ns() - start;
+
+    start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        generated_data.input = inputs[i];
+        generated_taken +=light_update(&generated);
+        light_execute(&generated);
+    }
+    const uint64_t generated_ns = now_ns() - start;
+
+    free(inputs);
+
+    printf("interpreted: %.2f ns/event\n", (double)interpreted_ns/events_num);
+    printf("generated:   %.2f ns/event\n", (double)generated_ns/events_num);
+
+    if(interpreted_data.trace!=generated_data.trace || interpreted.current->id!=generated.current
+        || interpreted_taken!=generated_taken) {
+        printf("traces differ\n");
+        return 1;
+    }
+
+    return check_session(events_num);
+}
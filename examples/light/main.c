@@ -1,6 +1,8 @@
 #include <stdio.h>
+#include <unistd.h>
 
 #include "fsm/fsm.h"
+#include "fsm/loop.h"
 
 typedef enum {
     EXAMPLE_STATE_ON,
@@ -31,6 +33,29 @@ bool trigger_turn_off_event(const void *context) {
     return *input=='2';
 }
 
+static fsm_loop_t loop;
+
+bool read_input(void *context, int fd) {
+    char *input = (char *)context;
+    char c;
+
+    if(read(fd, &c, 1)<=0) {
+        fsm_loop_stop(&loop);
+        return false;
+    }
+
+    if(c=='x') {
+        fsm_loop_stop(&loop);
+    }
+
+    if(c==' ' || c=='\n') {
+        return false;
+    }
+
+    *input = c;
+    return true;
+}
+
 int main() {
 
     char input = 'q';
@@ -47,14 +72,9 @@ int main() {
 
     fsm_start(&fsm, EXAMPLE_STATE_ON);
 
-    do {
-        char tmp[8] = {0};
-        scanf("%s[^\n]", tmp);
-        input = tmp[0];
+    loop.fsm = &fsm;
 
-        fsm_update(&fsm);
-        fsm_execute(&fsm);
-    } while(input!='x');
+    fsm_loop_add_source(&loop, STDIN_FILENO, read_input);
 
-    return 0;
+    return fsm_loop_run(&loop) ? 1 : 0;
 }
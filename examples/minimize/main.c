@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fsm/minimize.h"
+
+// a random base machine blown up into several interchangeable copies of every state, with
+// states nothing reaches and transitions shadowed by earlier ones for the same event; odd
+// base states are twins of the even ones before them except for one action, so only a
+// minimizer that compares actions keeps them apart; the
+// minimized table must produce the same callback trace as the original on a random stream,
+// its states must follow the map, and minimizing it again must change nothing
+
+#define EVENTS_NUM  16
+#define PER_STATE   4
+#define UNREACHABLE_NUM 20
+
+struct trace {
+    uint64_t hash;
+    uint64_t calls;
+};
+
+static uint32_t seed;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static void record(void *context, uint8_t tag) {
+    struct trace *trace = context;
+
+    trace->hash = trace->hash*31 + tag;
+    trace->calls++;
+}
+
+static void enter_a(void *context) { record(context, 1); }
+static void enter_b(void *context) { record(context, 2); }
+static void exit_a(void *context) { record(context, 3); }
+static void execute_a(void *context) { record(context, 4); }
+static void action_a(void *context) { record(context, 5); }
+static void action_b(void *context) { record(context, 6); }
+
+static const fsm_callback_t enters[] = {NULL, enter_a, enter_b};
+static const fsm_callback_t exits[] = {NULL, exit_a};
+static const fsm_callback_t executes[] = {NULL, execute_a};
+static const fsm_callback_t actions[] = {NULL, action_a, action_b};
+
+#define PICK(array, i) array[(i)%(sizeof(array)/sizeof(array[0]))]
+
+// copy c of base state s is c*base_num + s, unreachable states come last
+static void build(fsm_table_t *table, uint16_t base_num, uint16_t copies) {
+    const uint16_t states_num = base_num*copies + UNREACHABLE_NUM;
+
+    seed = 1;
+
+    for(uint16_t s=0; s<states_num; s++) {
+        const uint16_t base = s%base_num;
+
+        fsm_table_add_state(table, s, PICK(enters, base/2), PICK(executes, base/6), PICK(exits, base/14));
+    }
+
+    uint16_t *events = malloc(base_num*PER_STATE*sizeof(uint16_t));
+    uint16_t *targets = malloc(base_num*PER_STATE*sizeof(uint16_t));
+    fsm_callback_t *labels = malloc(base_num*PER_STATE*sizeof(fsm_callback_t));
+
+    for(uint32_t i=0; i<(uint32_t)base_num*PER_STATE; i++) {
+        const bool twin = (i/PER_STATE) & 1;
+
+        events[i] = twin ? events[i - PER_STATE] : random_next()%EVENTS_NUM;
+        targets[i] = twin ? targets[i - PER_STATE] : random_next()%base_num;
+        labels[i] = (twin && i%PER_STATE) ? labels[i - PER_STATE] : PICK(actions, i);
+    }
+
+    for(uint16_t c=0; c<copies; c++) {
+        for(uint16_t s=0; s<base_num; s++) {
+            for(uint16_t j=0; j<PER_STATE; j++) {
+                const uint32_t i = s*PER_STATE + j;
+                const uint16_t copy = random_next()%copies;
+
+                fsm_table_add_transition(table, c*base_num + s, copy*base_num + targets[i], events[i], labels[i]);
+            }
+
+            // shadowed by the first transition of the state
+            fsm_table_add_transition(table, c*base_num + s, random_next()%states_num, events[s*PER_STATE], action_b);
+        }
+    }
+
+    for(uint16_t s=base_num*copies; s<states_num; s++) {
+        fsm_table_add_transition(table, s, random_next()%base_num, random_next()%EVENTS_NUM, action_a);
+    }
+
+    free(events);
+    free(targets);
+    free(labels);
+}
+
+int main(int argc, char **argv) {
+    const uint16_t base_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 200;
+    const uint16_t copies = (argc>2) ? strtoul(argv[2], NULL, 10) : 5;
+    const size_t dispatches_num = (argc>3) ? strtoul(argv[3], NULL, 10) : 1000000;
+
+    if(!base_num || !copies || (uint32_t)base_num*copies + UNREACHABLE_NUM>=FSM_TABLE_NONE) {
+        printf("base states and copies must be positive and give fewer than %u states\n", FSM_TABLE_NONE - UNREACHABLE_NUM);
+        return 1;
+    }
+
+    fsm_table_t original = {0}, minimized = {0};
+    struct trace original_trace = {0}, minimized_trace = {0};
+    struct fsm_minimize_report report, again;
+
+    build(&original, base_num, copies);
+    build(&minimized, base_num, copies);
+
+    uint16_t *map = malloc(minimized.states_num*sizeof(uint16_t));
+
+    if(!map) {
+        return 1;
+    }
+
+    const uint16_t initial = fsm_minimize(&minimized, 0, map, &report);
+
+    printf("states %u -> %u, table bytes %zu -> %zu\n", report.states_before, report.states_after,
+        report.bytes_before, report.bytes_after);
+
+    fsm_table_build(&original);
+    fsm_table_build(&minimized);
+
+    original.context = &original_trace;
+    minimized.context = &minimized_trace;
+
+    fsm_table_start(&original, 0);
+    fsm_table_start(&minimized, initial);
+
+    if(map[original.current]!=minimized.current) {
+        printf("initial state does not follow the map\n");
+        return 1;
+    }
+
+    seed = 2;
+
+    for(size_t i=0; i<dispatches_num; i++) {
+        const uint16_t event = random_next()%EVENTS_NUM;
+
+        if(fsm_table_dispatch(&original, event)!=fsm_table_dispatch(&minimized, event)) {
+            printf("dispatch %zu taken differently\n", i);
+            return 1;
+        }
+
+        fsm_table_execute(&original);
+        fsm_table_execute(&minimized);
+
+        if(original_trace.hash!=minimized_trace.hash || map[original.current]!=minimized.current) {
+            printf("traces differ at dispatch %zu\n", i);
+            return 1;
+        }
+    }
+
+    printf("traces match over %zu dispatches, %llu callbacks\n", dispatches_num, (unsigned long long)original_trace.calls);
+
+    // the result is already minimal: a fresh copy minimized once more keeps every state
+    fsm_table_t twice = {0};
+
+    build(&twice, base_num, copies);
+    fsm_minimize(&twice, fsm_minimize(&twice, 0, NULL, NULL), NULL, &again);
+
+    if(report.states_after>base_num || again.states_after!=again.states_before
+        || again.states_after!=report.states_after) {
+        printf("not minimal: %u base states, %u after the second pass\n", base_num, again.states_after);
+        return 1;
+    }
+
+    fsm_table_free(&original);
+    fsm_table_free(&minimized);
+    fsm_table_free(&twice);
+    free(map);
+
+    return 0;
+}
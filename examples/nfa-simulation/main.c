@@ -0,0 +1,234 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/nfa.h"
+
+// a random NFA with epsilon cycles run by fsm_nfa and by a naive simulation that keeps
+// one flag per state, walks the edge list every event and closes epsilons to a fixpoint,
+// the active sets and acceptance must agree after every event
+
+#define STATES_NUM  FSM_NFA_STATE_MAX_NUM
+#define EVENTS_NUM  FSM_NFA_EVENT_MAX_NUM
+#define EDGES_NUM   (STATES_NUM*EVENTS_NUM)
+#define EPSILONS_NUM    (STATES_NUM/4)
+
+struct edge {
+    uint16_t from;
+    uint16_t to;
+    uint8_t event;
+};
+
+struct naive {
+    struct edge edges[EDGES_NUM];
+    struct edge epsilons[EPSILONS_NUM];
+    bool accepting[STATES_NUM];
+    bool active[STATES_NUM];
+};
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static void naive_close(struct naive *naive) {
+    bool changed = true;
+
+    while(changed) {
+        changed = false;
+
+        for(uint32_t i=0; i<EPSILONS_NUM; i++) {
+            const struct edge *epsilon = &naive->epsilons[i];
+
+            if(naive->active[epsilon->from] && !naive->active[epsilon->to]) {
+                naive->active[epsilon->to] = true;
+                changed = true;
+            }
+        }
+    }
+}
+
+static void naive_start(struct naive *naive, uint16_t initial) {
+    for(uint16_t s=0; s<STATES_NUM; s++) {
+        naive->active[s] = false;
+    }
+
+    naive->active[initial] = true;
+    naive_close(naive);
+}
+
+static void naive_dispatch(struct naive *naive, uint8_t event) {
+    bool next[STATES_NUM] = {false};
+
+    for(uint32_t i=0; i<EDGES_NUM; i++) {
+        const struct edge *edge = &naive->edges[i];
+
+        if(edge->event==event && naive->active[edge->from]) {
+            next[edge->to] = true;
+        }
+    }
+
+    for(uint16_t s=0; s<STATES_NUM; s++) {
+        naive->active[s] = next[s];
+    }
+
+    naive_close(naive);
+}
+
+static bool naive_accepts(const struct naive *naive) {
+    for(uint16_t s=0; s<STATES_NUM; s++) {
+        if(naive->active[s] && naive->accepting[s]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool naive_empty(const struct naive *naive) {
+    for(uint16_t s=0; s<STATES_NUM; s++) {
+        if(naive->active[s]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool nfa_empty(const fsm_nfa_t *nfa) {
+    for(uint16_t w=0; w<FSM_NFA_WORDS; w++) {
+        if(nfa->active.bits[w]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const size_t events_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    static fsm_nfa_t nfa;
+    static struct naive naive;
+
+    for(uint32_t i=0; i<EDGES_NUM; i++) {
+        struct edge *edge = &naive.edges[i];
+
+        edge->from = random_next()%STATES_NUM;
+        edge->to = random_next()%STATES_NUM;
+        edge->event = random_next()%EVENTS_NUM;
+        fsm_nfa_add_transition(&nfa, edge->from, edge->to, edge->event);
+    }
+
+    for(uint32_t i=0; i<EPSILONS_NUM; i++) {
+        struct edge *epsilon = &naive.epsilons[i];
+
+        epsilon->from = random_next()%STATES_NUM;
+        epsilon->to = random_next()%STATES_NUM;
+        fsm_nfa_add_epsilon(&nfa, epsilon->from, epsilon->to);
+    }
+
+    for(uint16_t s=0; s<STATES_NUM; s+=7) {
+        naive.accepting[s] = true;
+        fsm_nfa_set_accepting(&nfa, s);
+    }
+
+    // the last state always exists so both sides agree on the state count
+    fsm_nfa_add_epsilon(&nfa, STATES_NUM - 1, STATES_NUM - 1);
+    fsm_nfa_compile(&nfa);
+
+    uint8_t *events = malloc(events_num);
+    uint16_t *restarts = malloc(events_num*sizeof(uint16_t));
+
+    if(!events || !restarts) {
+        return 1;
+    }
+
+    for(size_t i=0; i<events_num; i++) {
+        events[i] = random_next()%EVENTS_NUM;
+    }
+
+    // both runs restart from a random state whenever the active set dies out
+    size_t restarts_num = 0;
+    uint64_t active_sum = 0;
+
+    naive_start(&naive, 0);
+
+    uint64_t start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        naive_dispatch(&naive, events[i]);
+
+        if(naive_empty(&naive)) {
+            restarts[restarts_num] = random_next()%STATES_NUM;
+            naive_start(&naive, restarts[restarts_num++]);
+        }
+    }
+    const uint64_t naive_ns = now_ns() - start;
+
+    size_t restart = 0;
+
+    naive_start(&naive, 0);
+    fsm_nfa_start(&nfa, 0);
+
+    for(size_t i=0; i<events_num; i++) {
+        naive_dispatch(&naive, events[i]);
+        fsm_nfa_dispatch(&nfa, events[i]);
+
+        if(naive_empty(&naive)) {
+            naive_start(&naive, restarts[restart]);
+            fsm_nfa_start(&nfa, restarts[restart++]);
+        }
+
+        for(uint16_t s=0; s<STATES_NUM; s++) {
+            if(fsm_nfa_is_active(&nfa, s)!=naive.active[s]) {
+                printf("state %u differs after event %zu\n", s, i);
+                return 1;
+            }
+
+            active_sum +=naive.active[s];
+        }
+
+        if(fsm_nfa_accepts(&nfa)!=naive_accepts(&naive)) {
+            printf("acceptance differs after event %zu\n", i);
+            return 1;
+        }
+    }
+
+    restart = 0;
+    fsm_nfa_start(&nfa, 0);
+
+    start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        fsm_nfa_dispatch(&nfa, events[i]);
+
+        // the active set empties at the same events as in the naive run, checked above
+        if(nfa_empty(&nfa)) {
+            fsm_nfa_start(&nfa, restarts[restart++]);
+        }
+    }
+    const uint64_t nfa_ns = now_ns() - start;
+
+    printf("%u states, %u events, %u edges, %u epsilons, %.1f active on average, %zu restarts\n",
+        STATES_NUM, EVENTS_NUM, EDGES_NUM, EPSILONS_NUM, (double)active_sum/events_num, restarts_num);
+    printf("naive    %8.2f ns/event %8.2f Mevents/s\n", (double)naive_ns/events_num, 1e3*events_num/naive_ns);
+    printf("fsm_nfa  %8.2f ns/event %8.2f Mevents/s\n", (double)nfa_ns/events_num, 1e3*events_num/nfa_ns);
+    printf("simulations match\n");
+
+    free(events);
+    free(restarts);
+
+    return 0;
+}
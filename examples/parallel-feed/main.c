@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "fsm/parallel.h"
+
+// a CSV field splitter fed serially and then in parallel with 1, 2, 4 and 8 threads; actions
+// fold their id and byte offset into a trace so both the order and the positions of the calls
+// must match the serial run; a second pass, not timed, makes thread creation fail now and then
+// where the linker can wrap pthread_create(); the size is in megabytes, 4096 and up feed
+// several pieces of FSM_PARALLEL_CHUNK_MAX_LEN per thread and need that much memory
+
+enum {
+    FIELD,
+    QUOTED,
+    QUOTE_END
+};
+
+struct scan {
+    const uint8_t *base;
+    uint64_t trace;
+    size_t actions_num;
+};
+
+static uint32_t seed = 1;
+
+static unsigned int creates_num;
+static unsigned int failures_num;
+
+#ifdef PARALLEL_FEED_WRAP
+// every fail_every-th pthread_create() fails, 0 never
+static unsigned int fail_every;
+
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*routine)(void *), void *arg);
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*routine)(void *), void *arg) {
+    creates_num++;
+
+    if(fail_every && creates_num%fail_every==0) {
+        failures_num++;
+        return EAGAIN;
+    }
+
+    return __real_pthread_create(thread, attr, routine, arg);
+}
+#endif
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static void record(void *context, uint8_t id, const uint8_t *byte) {
+    struct scan *scan = context;
+
+    scan->trace = scan->trace*31 + id*1000003 + (uint64_t)(byte - scan->base);
+    scan->actions_num++;
+}
+
+static void field(void *context, const uint8_t *byte) {
+    record(context, 1, byte);
+}
+
+static void row(void *context, const uint8_t *byte) {
+    record(context, 2, byte);
+}
+
+static bool build(fsm_stream_t *stream, bool actions) {
+    fsm_stream_add_transition(stream, FIELD, QUOTED, '"', '"', NULL);
+    fsm_stream_add_transition(stream, FIELD, FIELD, ',', ',', actions ? field : NULL);
+    fsm_stream_add_transition(stream, FIELD, FIELD, '\n', '\n', actions ? row : NULL);
+    fsm_stream_add_transition(stream, QUOTED, QUOTE_END, '"', '"', NULL);
+    fsm_stream_add_transition(stream, QUOTE_END, QUOTED, '"', '"', NULL);
+    fsm_stream_add_transition(stream, QUOTE_END, FIELD, ',', ',', actions ? field : NULL);
+    fsm_stream_add_transition(stream, QUOTE_END, FIELD, '\n', '\n', actions ? row : NULL);
+    fsm_stream_add_transition(stream, QUOTE_END, FIELD, 0, 255, NULL);
+
+    return fsm_stream_compile(stream);
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// feeds in parallel and compares with the serial run, returns the elapsed time or 0 on mismatch
+static uint64_t check_parallel(fsm_stream_t *stream, fsm_stream_t *recognizer, const uint8_t *input, size_t len,
+    unsigned int threads, const struct scan *serial, uint8_t serial_current, uint8_t recognizer_current) {
+    struct scan parallel = {.base = input};
+
+    creates_num = failures_num = 0;
+
+    stream->context = &parallel;
+    fsm_stream_start(stream, FIELD);
+    fsm_stream_start(recognizer, FIELD);
+
+    const uint64_t start = now_ns();
+    fsm_feed_parallel(stream, input, len, threads);
+    const uint64_t elapsed_ns = now_ns() - start;
+
+    fsm_feed_parallel(recognizer, input, len, threads);
+
+    if(parallel.trace!=serial->trace || parallel.actions_num!=serial->actions_num
+        || stream->current!=serial_current || recognizer->current!=recognizer_current) {
+        return 0;
+    }
+
+    return elapsed_ns ? elapsed_ns : 1;
+}
+
+int main(int argc, char **argv) {
+    const size_t len = (size_t)((argc>1) ? strtoull(argv[1], NULL, 10) : 64) << 20;
+
+    static const char alphabet[] = "abcdefgh0123456789 ,,,\"\"\n";
+    uint8_t *input = malloc(len);
+
+    if(!input) {
+        printf("cannot allocate %zu bytes\n", len);
+        return 1;
+    }
+
+    for(size_t i=0; i<len; i++) {
+        input[i] = alphabet[random_next()%(sizeof(alphabet) - 1)];
+    }
+
+    static fsm_stream_t stream, recognizer;
+    struct scan serial = {.base = input};
+
+    if(!build(&stream, true) || !build(&recognizer, false)) {
+        printf("byte classes do not fit FSM_STREAM_CLASS_MAX_NUM\n");
+        return 1;
+    }
+
+    stream.context = &serial;
+    fsm_stream_start(&stream, FIELD);
+    fsm_stream_start(&recognizer, FIELD);
+
+    const uint64_t start = now_ns();
+    fsm_feed(&stream, input, len);
+    printf("serial      %8.3f GB/s  %zu actions\n", (double)len/(now_ns() - start), serial.actions_num);
+
+    fsm_feed(&recognizer, input, len);
+
+    const uint8_t serial_current = stream.current;
+    const uint8_t recognizer_current = recognizer.current;
+
+    static const unsigned int threads[] = {1, 2, 4, 8};
+
+    for(size_t t=0; t<sizeof(threads)/sizeof(threads[0]); t++) {
+        const uint64_t elapsed_ns = check_parallel(&stream, &recognizer, input, len, threads[t], &serial, serial_current,
+            recognizer_current);
+
+        if(!elapsed_ns) {
+            printf("parallel feed with %u threads differs from fsm_feed\n", threads[t]);
+            return 1;
+        }
+
+        printf("%u threads %8.3f GB/s\n", threads[t], (double)len/elapsed_ns);
+    }
+
+#ifdef PARALLEL_FEED_WRAP
+    static const unsigned int fail_everys[] = {2, 3};
+
+    for(size_t f=0; f<sizeof(fail_everys)/sizeof(fail_everys[0]); f++) {
+        fail_every = fail_everys[f];
+
+        for(size_t t=1; t<sizeof(threads)/sizeof(threads[0]); t++) {
+            if(!check_parallel(&stream, &recognizer, input, len, threads[t], &serial, serial_current, recognizer_current)) {
+                printf("parallel feed with %u threads and every %uth creation failing differs from fsm_feed\n",
+                    threads[t], fail_every);
+                return 1;
+            }
+
+            printf("%u threads, %u of %u thread creations failed, same result\n", threads[t], failures_num,
+                creates_num);
+        }
+    }
+
+    fail_every = 0;
+#else
+    printf("thread creation failures not injected, the linker cannot wrap pthread_create()\n");
+#endif
+
+    printf("parallel feeds match fsm_feed\n");
+
+    free(input);
+
+    return 0;
+}
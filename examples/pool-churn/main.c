@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/pool.h"
+
+// connection churn: every round replaces a random live instance with a new one and updates
+// another, first through the pool, then with a malloc'd fsm_t that is rebuilt per connection;
+// stale handles have to be rejected, also by the NDEBUG build where no assert guards them
+
+#define STATES_NUM  4
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void) {
+    seed ^=seed << 13;
+    seed ^=seed >> 17;
+    seed ^=seed << 5;
+
+    return seed;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void build(fsm_t *fsm) {
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_state(fsm, s, NULL, NULL, NULL);
+    }
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_transition(fsm, s, (s + 1)%STATES_NUM, NULL, NULL);
+    }
+}
+
+static uint32_t executed = 0;
+
+static void count_execute(void *context) {
+    (void)context;
+    executed++;
+}
+
+// stale, made-up and out of range handles must be rejected by every call taking one without
+// touching any instance, returns the number of calls that did not
+static int check_stale(void) {
+    static fsm_t definition;
+    fsm_pool_t pool;
+    fsm_handle_t live[3];
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_state(&definition, s, NULL, count_execute, NULL);
+    }
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_transition(&definition, s, (s + 1)%STATES_NUM, NULL, NULL);
+    }
+
+    const size_t size = fsm_freeze(&definition, NULL, 0);
+    void *frozen = malloc(size);
+
+    if(!frozen) {
+        return 1;
+    }
+
+    fsm_freeze(&definition, frozen, size);
+    fsm_pool_init(&pool, definition.frozen, 8);
+
+    for(uint32_t i=0; i<3; i++) {
+        live[i] = fsm_pool_create(&pool, NULL, 0);
+    }
+
+    const fsm_handle_t destroyed = fsm_pool_create(&pool, NULL, 0);
+
+    fsm_pool_destroy(&pool, destroyed);
+
+    // the destroyed slot again, a never used free slot with the generation it would get, a
+    // slot past the capacity, a live slot with a wrong generation and no handle at all
+    const fsm_handle_t bad[] = {
+        destroyed,
+        ((fsm_handle_t)1 << 32) | 6,
+        ((fsm_handle_t)1 << 32) | 1000,
+        live[1] + ((fsm_handle_t)1 << 32),
+        FSM_POOL_NONE
+    };
+    int failures = 0;
+
+    for(uint32_t i=0; i<sizeof(bad)/sizeof(bad[0]); i++) {
+        uint8_t state = 0xAA;
+
+        failures +=fsm_pool_valid(&pool, bad[i]);
+        failures +=fsm_pool_update(&pool, bad[i]);
+        failures +=fsm_pool_execute(&pool, bad[i]);
+        failures +=fsm_pool_state(&pool, bad[i], &state) || state!=0xAA;
+        failures +=(fsm_pool_next(&pool, bad[i])!=FSM_POOL_NONE);
+        failures +=fsm_pool_destroy(&pool, bad[i]);
+    }
+
+    failures +=(executed!=0 || pool.instances_num!=3 || fsm_pool_count(&pool, 0)!=3);
+
+    for(uint32_t i=0; i<3; i++) {
+        uint8_t state;
+
+        failures +=!fsm_pool_update(&pool, live[i]);
+        failures +=!fsm_pool_state(&pool, live[i], &state) || state!=1;
+    }
+
+    fsm_pool_free(&pool);
+    free(frozen);
+
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t live_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000;
+    const uint32_t rounds = (argc>2) ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    static fsm_t definition;
+    fsm_pool_t pool;
+    fsm_handle_t *handles = malloc(live_num*sizeof(fsm_handle_t));
+    fsm_t **machines = malloc(live_num*sizeof(fsm_t *));
+    const int stale_failures = check_stale();
+
+    build(&definition);
+
+    const size_t size = fsm_freeze(&definition, NULL, 0);
+    void *frozen = malloc(size);
+
+    if(!handles || !machines || !frozen) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    fsm_freeze(&definition, frozen, size);
+    fsm_pool_init(&pool, definition.frozen, live_num);
+
+    for(uint32_t i=0; i<live_num; i++) {
+        handles[i] = fsm_pool_create(&pool, NULL, 0);
+    }
+
+    uint32_t stale = 0;
+    uint64_t start = now_ns();
+
+    for(uint32_t r=0; r<rounds; r++) {
+        const uint32_t victim = next_random()%live_num;
+        const fsm_handle_t old = handles[victim];
+
+        fsm_pool_destroy(&pool, old);
+        handles[victim] = fsm_pool_create(&pool, NULL, 0);
+        fsm_pool_update(&pool, handles[next_random()%live_num]);
+
+        stale +=fsm_pool_valid(&pool, old);
+    }
+
+    const double pooled = (double)(now_ns() - start)/rounds;
+
+    for(uint32_t i=0; i<live_num; i++) {
+        machines[i] = calloc(1, sizeof(fsm_t));
+        build(machines[i]);
+        fsm_start(machines[i], 0);
+    }
+
+    start = now_ns();
+
+    for(uint32_t r=0; r<rounds; r++) {
+        const uint32_t victim = next_random()%live_num;
+
+        free(machines[victim]);
+        machines[victim] = calloc(1, sizeof(fsm_t));
+        build(machines[victim]);
+        fsm_start(machines[victim], 0);
+        fsm_update(machines[next_random()%live_num]);
+    }
+
+    const double rebuilt = (double)(now_ns() - start)/rounds;
+
+    printf("%u live, %u rounds of destroy + create + update\n", live_num, rounds);
+    printf("pool     %8.2f ns/round  %10.0f rounds/s  %zu bytes/instance\n", pooled, 1e9/pooled,
+        sizeof(struct fsm_pool_entry) + 2*sizeof(uint32_t));
+    printf("rebuild  %8.2f ns/round  %10.0f rounds/s  %zu bytes/instance\n", rebuilt, 1e9/rebuilt, sizeof(fsm_t));
+
+    for(uint32_t i=0; i<live_num; i++) {
+        free(machines[i]);
+    }
+
+    const uint32_t live = pool.instances_num;
+
+    fsm_pool_free(&pool);
+    free(frozen);
+    free(machines);
+    free(handles);
+
+    if(stale || live!=live_num || stale_failures) {
+        printf("%u stale handles still valid, %u live, %d calls accepted a bad handle\n", stale, live,
+            stale_failures);
+        return 1;
+    }
+
+    return 0;
+}
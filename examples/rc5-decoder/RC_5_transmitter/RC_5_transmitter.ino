@@ -2,10 +2,23 @@
 
 TransmitterRC5 transmitter(7);
 
+ISR(TIMER1_COMPA_vect) {
+  transmitter.tick();
+}
+
 void setup(){
   Serial.begin(115200);
 
   pinMode(13, OUTPUT);
+
+  // Timer1 in CTC mode, 16 MHz / 8 = 2 ticks per us, one interrupt per half bit
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = (1<<WGM12) | (1<<CS11);
+  TCNT1 = 0;
+  OCR1A = 2*HALF_BIT - 1;
+  TIMSK1 = (1<<OCIE1A);
+  interrupts();
 }
 
 uint8_t toggle = 0;
@@ -14,6 +27,10 @@ uint8_t command = 0;
 
 void loop(){
 
+  if(!transmitter.send(toggle, address, command)) {
+    return;
+  }
+
   digitalWrite(13, toggle);
 
   Serial.print("Toggle: ");
@@ -23,12 +40,9 @@ void loop(){
   Serial.print(" Command: 0x");
   Serial.println(command, HEX);
 
-  transmitter.send(toggle, address, command);
-
   toggle = !toggle;
   command++;
   command %=0x40;
   
   delay(1000);
 }
-
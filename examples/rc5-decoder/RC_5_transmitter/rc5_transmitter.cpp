@@ -2,41 +2,66 @@
 
 TransmitterRC5::TransmitterRC5(int pin) {
   this->pin = pin;
+  this->head = 0;
+  this->tail = 0;
+  this->state = IDLE;
   
   pinMode(this->pin, OUTPUT);
+  digitalWrite(this->pin, HIGH);
 }
 
-void TransmitterRC5::sendBit(bool bit) {
-  if(bit) {
-    digitalWrite(this->pin, HIGH);
-    delayMicroseconds(PULSE);
-    digitalWrite(this->pin, LOW);
-    delayMicroseconds(SPACE);
-  } else {
-    digitalWrite(this->pin, LOW);
-    delayMicroseconds(SPACE);
-    digitalWrite(this->pin, HIGH);
-    delayMicroseconds(PULSE);
-  }
+bool TransmitterRC5::currentBit() const {
+  return (this->frame & (1<<this->bit))>0;
 }
 
-void TransmitterRC5::send(uint8_t toggle, uint8_t address, uint8_t command) {
+bool TransmitterRC5::send(uint8_t toggle, uint8_t address, uint8_t command) {
   toggle &=0x01;
   address &=0x1F;
   command &=0x3F;
   
   uint16_t frame = (3<<12) | ((uint16_t)toggle<<11) | ((uint16_t)address<<6) | command;
 
-  Serial.println(frame, HEX);
-
-  for(int i=13; i>=0; i--) {
-    bool bit = (frame & (1<<i))>0;
-
-    this->sendBit(bit);
-    Serial.print(bit);
+  if((uint8_t)(this->head - this->tail)==QUEUE_SIZE) {
+    return false;
   }
-  Serial.println("");
 
-  digitalWrite(this->pin, HIGH);
+  this->queue[this->head & (QUEUE_SIZE - 1)] = frame;
+  this->head++;
+
+  return true;
 }
 
+// must be called every HALF_BIT from a timer interrupt, every call changes at most one edge
+void TransmitterRC5::tick() {
+  switch(this->state) {
+    case IDLE:
+      if(this->head==this->tail) {
+        return;
+      }
+
+      this->frame = this->queue[this->tail & (QUEUE_SIZE - 1)];
+      this->tail++;
+      this->bit = 13;
+      this->state = FIRST_HALF;
+      // fall through
+    case FIRST_HALF:
+      digitalWrite(this->pin, this->currentBit() ? HIGH : LOW);
+      this->state = SECOND_HALF;
+      break;
+    case SECOND_HALF:
+      digitalWrite(this->pin, this->currentBit() ? LOW : HIGH);
+      this->bit--;
+      this->state = (this->bit<0) ? STOP : FIRST_HALF;
+      break;
+    case STOP:
+      digitalWrite(this->pin, HIGH);
+      this->gap = GAP_TICKS;
+      this->state = GAP;
+      break;
+    case GAP:
+      if(--this->gap==0) {
+        this->state = IDLE;
+      }
+      break;
+  }
+}
@@ -3,16 +3,35 @@
 #include <stdint.h>
 #include <Arduino.h>
 
-#define SPACE   889 // us
-#define PULSE   889 // us
+#define HALF_BIT    889 // us, tick() period
+#define GAP_TICKS   100 // half bits of silence between frames
+#define QUEUE_SIZE  4   // frames, power of two
 
 class TransmitterRC5 {
+    enum State {
+      IDLE,
+      FIRST_HALF,
+      SECOND_HALF,
+      STOP,
+      GAP
+    };
+
     int pin;
 
-    void sendBit(bool);
+    volatile uint16_t queue[QUEUE_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+
+    State state;
+    uint16_t frame;
+    int8_t bit;
+    uint8_t gap;
+
+    bool currentBit() const;
   public:
     TransmitterRC5(int);
 
-    void send(uint8_t, uint8_t, uint8_t);
-};
+    bool send(uint8_t, uint8_t, uint8_t);
 
+    void tick();
+};
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "rc5_decoder.h"
+#include "sim.h"
+
+// drives DecoderRC5 with the edges of Manchester coded frames on a simulated 1 us timer, first
+// with timing jitter and a consumer that drains after every frame, then with bursts the
+// consumer drains only once they are over; frames beyond RC5_QUEUE_SIZE must be counted as
+// dropped and every other frame has to come out intact and in order
+
+#define JITTER          200     // us, per edge, RC5_TIME_TOLERANCE allows up to twice this
+#define GAP             (100*RC5_TIME_SHORT)
+#define FRAMES_NUM      1000
+#define BURST_MAX       16
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void) {
+    seed ^=seed << 13;
+    seed ^=seed >> 17;
+    seed ^=seed << 5;
+
+    return seed;
+}
+
+// the receiver output is high for the first half of a 1 and low for the second, the other way
+// round for a 0
+static void send(uint16_t frame, uint32_t jitter) {
+    const uint64_t start = sim_now() + GAP;
+
+    for(uint8_t half=0; half<=28; half++) {
+        const uint8_t bit = (half<28) ? (frame >> (13 - half/2)) & 1 : 0;
+        const uint8_t level = (half==28) ? 1 : (half & 1) ? !bit : bit;
+
+        if(level!=sim_level()) {
+            const int32_t offset = jitter ? (int32_t)(next_random()%(2*jitter + 1)) - (int32_t)jitter : 0;
+
+            sim_edge(start + (uint64_t)half*RC5_TIME_SHORT + offset, level);
+        }
+    }
+}
+
+static uint16_t random_frame(void) {
+    return (3 << 12) | (next_random() & 0x0FFF);
+}
+
+int main(void) {
+    uint16_t frame;
+    int result = 0;
+
+    sim_setup();
+
+    uint32_t decoded = 0;
+
+    for(uint32_t i=0; i<FRAMES_NUM; i++) {
+        const uint16_t sent = random_frame();
+
+        send(sent, JITTER);
+
+        while(sim_get_frame(&frame)) {
+            decoded +=(frame==sent);
+            result |=(frame!=sent);
+        }
+    }
+
+    printf("jitter +-%u us: %u of %u frames decoded, %lu dropped\n", JITTER, decoded, FRAMES_NUM,
+        (unsigned long)sim_dropped());
+
+    result |=(decoded!=FRAMES_NUM || sim_dropped());
+
+    printf("burst  received  dropped\n");
+
+    for(uint32_t burst=1; burst<=BURST_MAX; burst++) {
+        uint16_t frames[BURST_MAX];
+        uint32_t received = 0;
+
+        sim_setup();
+
+        for(uint32_t i=0; i<burst; i++) {
+            frames[i] = random_frame();
+            send(frames[i], 0);
+        }
+
+        while(sim_get_frame(&frame)) {
+            result |=(frame!=frames[received]);
+            received++;
+        }
+
+        const uint32_t dropped = sim_dropped();
+        const uint32_t expected = (burst<RC5_QUEUE_SIZE) ? burst : RC5_QUEUE_SIZE;
+
+        printf("%5u  %8u  %7u\n", burst, received, dropped);
+
+        result |=(received!=expected || dropped!=burst - expected);
+    }
+
+    printf("%s\n", result ? "decoder lost or corrupted frames" : "no frame lost beyond the queue");
+
+    return result;
+}
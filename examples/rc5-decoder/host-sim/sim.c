@@ -0,0 +1,66 @@
+#include "rc5_decoder.h"
+#include "sim.h"
+
+#define TIMER_PERIOD    65536   // us, htim11 overflows after this much silence
+
+static DecoderRC5_t decoder;
+static GPIO_TypeDef port;
+static TIM_TypeDef timer;
+static TIM_HandleTypeDef htim;
+
+static uint64_t now;
+static uint64_t timer_base;
+
+void sim_setup(void) {
+    decoder = (DecoderRC5_t){0};
+    port = (GPIO_TypeDef){.level = 1};
+    timer = (TIM_TypeDef){0};
+    htim.Instance = &timer;
+    now = 0;
+    timer_base = 0;
+
+    DecoderRC5_Init(&decoder, &htim, &port, 1);
+}
+
+// runs the overflow interrupts due until t, then the EXTI interrupt of an edge at t; level is
+// the receiver output, low while the carrier is on
+void sim_edge(uint64_t t, uint8_t level) {
+    while(t - timer_base>=TIMER_PERIOD) {
+        timer_base +=TIMER_PERIOD;
+        DecoderRC5_PeriodElapsedCallback(&decoder, &htim);
+    }
+
+    now = t;
+    port.level = level;
+    timer.counter = (uint32_t)(t - timer_base);
+
+    DecoderRC5_EXTI_Callback(&decoder, 1);
+
+    if(timer.counter==0) {
+        timer_base = t;
+    }
+}
+
+uint64_t sim_now(void) {
+    return now;
+}
+
+uint8_t sim_level(void) {
+    return port.level;
+}
+
+uint8_t sim_get_frame(uint16_t *frame) {
+    RC5_Message_t message;
+
+    if(!DecoderRC5_GetMessage(&decoder, &message)) {
+        return 0;
+    }
+
+    *frame = message.frame;
+
+    return 1;
+}
+
+uint32_t sim_dropped(void) {
+    return DecoderRC5_GetDropped(&decoder);
+}
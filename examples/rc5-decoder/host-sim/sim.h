@@ -0,0 +1,23 @@
+#ifndef RC5_HOST_SIM_H
+#define RC5_HOST_SIM_H
+
+// one DecoderRC5 on a simulated 1 us timer, its input pin driven by the harness
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sim_setup(void);
+void sim_edge(uint64_t t, uint8_t level);
+uint64_t sim_now(void);
+uint8_t sim_level(void);
+uint8_t sim_get_frame(uint16_t *frame);
+uint32_t sim_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// pin functions used by rc5_transmitter.cpp, the harness provides them
+
+#include <stdint.h>
+
+#define LOW     0
+#define HIGH    1
+#define OUTPUT  1
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int level);
+
+#endif
@@ -0,0 +1,61 @@
+#include <assert.h>
+#include <string.h>
+
+#include "finite_state_machine.h"
+
+void FiniteStateMachine_Init(FiniteStateMachine_t *fsm, void *context) {
+    memset(fsm, 0, sizeof(*fsm));
+    fsm->context = context;
+}
+
+void FiniteStateMachine_DefineState(FiniteStateMachine_t *fsm, uint8_t id, FiniteStateMachine_Callback_t enter,
+    FiniteStateMachine_Callback_t execute, FiniteStateMachine_Callback_t exit) {
+    assert(id<FSM_LEGACY_STATE_MAX_NUM);
+
+    fsm->states[id].enter = enter;
+    fsm->states[id].execute = execute;
+    fsm->states[id].exit = exit;
+}
+
+void FiniteStateMachine_DefineTransition(FiniteStateMachine_t *fsm, uint8_t from, uint8_t to, uint8_t priority,
+    FiniteStateMachine_Callback_t action, FiniteStateMachine_Trigger_t trigger) {
+    (void)priority;
+
+    assert(fsm->transitions_num<FSM_LEGACY_TRANSITION_MAX_NUM);
+
+    fsm->transitions[fsm->transitions_num++] = (FiniteStateMachine_Transition_t){from, to, action, trigger};
+}
+
+void FiniteStateMachine_Start(FiniteStateMachine_t *fsm, uint8_t initial) {
+    fsm->current = initial;
+
+    if(fsm->states[initial].enter) {
+        fsm->states[initial].enter(fsm->context);
+    }
+}
+
+void FiniteStateMachine_Update(FiniteStateMachine_t *fsm) {
+    for(uint8_t i=0; i<fsm->transitions_num; i++) {
+        const FiniteStateMachine_Transition_t *transition = &fsm->transitions[i];
+
+        if(transition->from!=fsm->current || (transition->trigger && !transition->trigger(fsm->context))) {
+            continue;
+        }
+
+        if(fsm->states[fsm->current].exit) {
+            fsm->states[fsm->current].exit(fsm->context);
+        }
+
+        if(transition->action) {
+            transition->action(fsm->context);
+        }
+
+        fsm->current = transition->to;
+
+        if(fsm->states[fsm->current].enter) {
+            fsm->states[fsm->current].enter(fsm->context);
+        }
+
+        return;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef FINITE_STATE_MACHINE_H
+#define FINITE_STATE_MACHINE_H
+
+// the decoder was written against the older FiniteStateMachine_* API which is not part of this
+// tree, this is a host stand-in with the same semantics as fsm_update(): the first transition
+// whose trigger is NULL or true runs exit, action and enter
+
+#include <stdint.h>
+
+#define FSM_LEGACY_STATE_MAX_NUM        8
+#define FSM_LEGACY_TRANSITION_MAX_NUM   16
+
+typedef void (*FiniteStateMachine_Callback_t)(void *);
+typedef uint8_t (*FiniteStateMachine_Trigger_t)(void *);
+
+typedef struct {
+    FiniteStateMachine_Callback_t enter;
+    FiniteStateMachine_Callback_t execute;
+    FiniteStateMachine_Callback_t exit;
+} FiniteStateMachine_State_t;
+
+typedef struct {
+    uint8_t from;
+    uint8_t to;
+    FiniteStateMachine_Callback_t action;
+    FiniteStateMachine_Trigger_t trigger;
+} FiniteStateMachine_Transition_t;
+
+typedef struct {
+    void *context;
+    uint8_t current;
+
+    FiniteStateMachine_State_t states[FSM_LEGACY_STATE_MAX_NUM];
+    FiniteStateMachine_Transition_t transitions[FSM_LEGACY_TRANSITION_MAX_NUM];
+    uint8_t transitions_num;
+} FiniteStateMachine_t;
+
+void FiniteStateMachine_Init(FiniteStateMachine_t *, void *);
+void FiniteStateMachine_DefineState(FiniteStateMachine_t *, uint8_t, FiniteStateMachine_Callback_t, FiniteStateMachine_Callback_t, FiniteStateMachine_Callback_t);
+void FiniteStateMachine_DefineTransition(FiniteStateMachine_t *, uint8_t, uint8_t, uint8_t, FiniteStateMachine_Callback_t, FiniteStateMachine_Trigger_t);
+void FiniteStateMachine_Start(FiniteStateMachine_t *, uint8_t);
+void FiniteStateMachine_Update(FiniteStateMachine_t *);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+// just enough of the HAL for rc5_decoder.c and com.c on the host, the harnesses drive pin,
+// counter and UART, and provide the functions declared here
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t level;
+} GPIO_TypeDef;
+
+typedef struct {
+    uint32_t counter;
+} TIM_TypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    uint32_t baud;
+} UART_HandleTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define __HAL_TIM_GET_COUNTER(htim)         ((htim)->Instance->counter)
+#define __HAL_TIM_SET_COUNTER(htim, value)  ((htim)->Instance->counter = (value))
+#define __DMB()                             __sync_synchronize()
+#define __HAL_UART_CLEAR_OREFLAG(huart)     ((void)(huart))
+#define HAL_MAX_DELAY                       0xFFFFFFFFU
+
+// the mock TX complete interrupt runs on its own thread, com.c ring indices are atomic
+#define UART_TX_SHARED                      _Atomic
+
+int HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+int HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+
+// interrupt masking and the active exception number as seen by the calling thread
+uint32_t __get_PRIMASK(void);
+uint32_t __get_IPSR(void);
+void __disable_irq(void);
+void __set_PRIMASK(uint32_t primask);
+
+static inline GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+    (void)pin;
+
+    return port->level ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+static inline int HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    (void)htim;
+
+    return 0;
+}
+
+#endif
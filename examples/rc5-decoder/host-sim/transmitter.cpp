@@ -0,0 +1,74 @@
+#include <stdio.h>
+
+#include "rc5_transmitter.h"
+#include "sim.h"
+
+// runs TransmitterRC5::tick() on a simulated timer every HALF_BIT and wires its pin straight
+// into the decoder the way the two boards are connected; every interval between edges of a
+// frame must be one or two half bits, and every queued frame has to be decoded
+
+#define FRAMES_NUM  256
+
+static uint64_t now;
+static uint64_t last_edge;
+static bool started;
+static uint8_t level = HIGH;
+static uint32_t bad_intervals;
+
+void pinMode(int pin, int mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(int pin, int value) {
+    (void)pin;
+
+    if(value==level) {
+        return;
+    }
+
+    const uint64_t interval = now - last_edge;
+
+    // the first edge of a frame follows the gap
+    if(started && interval<GAP_TICKS*HALF_BIT && interval!=HALF_BIT && interval!=2*HALF_BIT) {
+        bad_intervals++;
+    }
+
+    started = true;
+    level = value;
+    last_edge = now;
+
+    sim_edge(now, level);
+}
+
+int main() {
+    TransmitterRC5 transmitter(7);
+    uint16_t frame;
+    uint32_t sent = 0;
+    uint32_t decoded = 0;
+    uint32_t mismatched = 0;
+    uint16_t expected[FRAMES_NUM];
+
+    sim_setup();
+
+    // refill the transmitter queue whenever there is room, tick until everything is out
+    while(sent<FRAMES_NUM || now<last_edge + 200*HALF_BIT) {
+        while(sent<FRAMES_NUM && transmitter.send(sent & 1, sent >> 1, sent)) {
+            expected[sent] = (3 << 12) | ((sent & 1) << 11) | (((sent >> 1) & 0x1F) << 6) | (sent & 0x3F);
+            sent++;
+        }
+
+        now +=HALF_BIT;
+        transmitter.tick();
+
+        while(sim_get_frame(&frame)) {
+            mismatched +=(decoded>=sent || frame!=expected[decoded]);
+            decoded++;
+        }
+    }
+
+    printf("%u frames sent, %u decoded, %u mismatched, %u edges off the half-bit grid, %lu dropped\n", sent, decoded,
+        mismatched, bad_intervals, (unsigned long)sim_dropped());
+
+    return (decoded!=sent || mismatched || bad_intervals || sim_dropped()) ? 1 : 0;
+}
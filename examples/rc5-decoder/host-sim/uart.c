@@ -0,0 +1,235 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "com.h"
+
+// runs com.c against a mock USART at 115200 baud: a thread plays the TX complete interrupt
+// after 10 bit times per byte, __disable_irq() holds a lock that interrupt takes as well;
+// measures how long _write stalls the caller for a burst and for paced lines, against what a
+// blocking HAL_UART_Transmit would cost, checks the bytes on the wire, and checks that a full
+// ring with interrupts masked drops instead of hanging; the burst is far larger than the ring,
+// so it waits for all but a ring's worth of the wire time and is only reported, paced lines
+// fit the ring and must stay under STALL_LIMIT, a quarter of the time a line takes on the wire
+
+#define BAUD            115200
+#define LINE_LENGTH     48
+#define BURST_LINES     200
+#define PACED_LINES     50
+#define PACED_PERIOD    10000000    // ns between lines, a line takes about 4.2 ms on the wire
+#define STALL_LIMIT     1000000     // ns a paced line may stall
+
+static UART_HandleTypeDef huart = {.baud = BAUD};
+
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local bool masked;
+static _Thread_local bool in_isr;
+
+static pthread_mutex_t transfer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t transfer_started = PTHREAD_COND_INITIALIZER;
+static const uint8_t *transfer_data;
+static uint16_t transfer_size;
+static bool running = true;
+
+static uint8_t wire[BURST_LINES*LINE_LENGTH + PACED_LINES*LINE_LENGTH + 2*UART_TX_BUFFER_SIZE];
+static _Atomic uint32_t wire_num;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = {.tv_sec = ns/1000000000, .tv_nsec = ns%1000000000};
+
+    nanosleep(&ts, NULL);
+}
+
+uint32_t __get_PRIMASK(void) {
+    return masked;
+}
+
+uint32_t __get_IPSR(void) {
+    return in_isr;
+}
+
+void __disable_irq(void) {
+    if(!masked) {
+        pthread_mutex_lock(&irq_lock);
+        masked = true;
+    }
+}
+
+void __set_PRIMASK(uint32_t primask) {
+    if(primask) {
+        __disable_irq();
+    } else if(masked) {
+        masked = false;
+        pthread_mutex_unlock(&irq_lock);
+    }
+}
+
+int HAL_UART_Transmit_IT(UART_HandleTypeDef *h, const uint8_t *data, uint16_t size) {
+    (void)h;
+
+    pthread_mutex_lock(&transfer_lock);
+    transfer_data = data;
+    transfer_size = size;
+    pthread_cond_signal(&transfer_started);
+    pthread_mutex_unlock(&transfer_lock);
+
+    return 0;
+}
+
+int HAL_UART_Receive(UART_HandleTypeDef *h, uint8_t *data, uint16_t size, uint32_t timeout) {
+    (void)h;
+    (void)timeout;
+
+    memset(data, 0, size);
+
+    return 0;
+}
+
+static void * run_uart(void *arg) {
+    (void)arg;
+
+    for(;;) {
+        pthread_mutex_lock(&transfer_lock);
+
+        while(!transfer_size && running) {
+            pthread_cond_wait(&transfer_started, &transfer_lock);
+        }
+
+        const uint8_t *data = transfer_data;
+        const uint16_t size = transfer_size;
+
+        transfer_size = 0;
+        pthread_mutex_unlock(&transfer_lock);
+
+        if(!size) {
+            return NULL;
+        }
+
+        sleep_ns((uint64_t)size*10*1000000000/huart.baud);
+
+        // the interrupt is held off while the main thread masks
+        pthread_mutex_lock(&irq_lock);
+        in_isr = true;
+
+        memcpy(&wire[wire_num], data, size);
+        wire_num +=size;
+        HAL_UART_TxCpltCallback(&huart);
+
+        in_isr = false;
+        pthread_mutex_unlock(&irq_lock);
+    }
+}
+
+static void make_line(char *line, uint32_t i) {
+    snprintf(line, LINE_LENGTH + 1, "Toggle: %u Address: 0x%02X Command: 0x%02X %06u\r\n", i & 1, (i >> 1) & 0x1F, i & 0x3F, i);
+    memset(line + strlen(line), '.', LINE_LENGTH - strlen(line));
+}
+
+static void wait_wire(uint32_t expected) {
+    while(wire_num<expected) {
+        sleep_ns(1000000);
+    }
+}
+
+// returns the longest stall, adds every line to expected
+static uint64_t print_lines(uint32_t lines, uint64_t period, uint8_t *expected, uint32_t *expected_num, uint64_t *total) {
+    char line[LINE_LENGTH + 1];
+    uint64_t longest = 0;
+
+    *total = 0;
+
+    for(uint32_t i=0; i<lines; i++) {
+        const uint64_t due = now_ns() + period;
+
+        make_line(line, i);
+        memcpy(&expected[*expected_num], line, LINE_LENGTH);
+        *expected_num +=LINE_LENGTH;
+
+        const uint64_t start = now_ns();
+
+        _write(1, line, LINE_LENGTH);
+
+        const uint64_t stall = now_ns() - start;
+
+        *total +=stall;
+        longest = (stall>longest) ? stall : longest;
+
+        if(period) {
+            sleep_ns(due - now_ns()<period ? due - now_ns() : 0);
+        }
+    }
+
+    return longest;
+}
+
+int main(void) {
+    static uint8_t expected[sizeof(wire)];
+    uint32_t expected_num = 0;
+    pthread_t uart;
+    uint64_t total;
+    int result = 0;
+
+    UART_SetSTDOUT(&huart);
+    pthread_create(&uart, NULL, run_uart, NULL);
+
+    const double byte_ns = 10*1e9/BAUD;
+    const uint64_t start = now_ns();
+    const uint64_t burst_longest = print_lines(BURST_LINES, 0, expected, &expected_num, &total);
+    const uint64_t burst_total = total;
+
+    wait_wire(expected_num);
+
+    const double throughput = expected_num/((now_ns() - start)/1e9);
+
+    printf("burst  %u lines: stalled %8.2f ms in total, %6.2f ms at most, blocking %8.2f ms, %.0f bytes/s on the wire\n",
+        BURST_LINES, burst_total/1e6, burst_longest/1e6, BURST_LINES*LINE_LENGTH*byte_ns/1e6, throughput);
+
+    const uint64_t paced_longest = print_lines(PACED_LINES, PACED_PERIOD, expected, &expected_num, &total);
+
+    wait_wire(expected_num);
+
+    printf("paced  %u lines: stalled %8.2f ms in total, %6.2f ms at most, blocking %8.2f ms\n", PACED_LINES, total/1e6,
+        paced_longest/1e6, PACED_LINES*LINE_LENGTH*byte_ns/1e6);
+
+    // two rings worth with interrupts masked, the second has nowhere to go
+    static char fill[2*UART_TX_BUFFER_SIZE];
+
+    memset(fill, '#', sizeof(fill));
+    memcpy(&expected[expected_num], fill, UART_TX_BUFFER_SIZE);
+    expected_num +=UART_TX_BUFFER_SIZE;
+
+    __disable_irq();
+    _write(1, fill, sizeof(fill));
+    __set_PRIMASK(0);
+
+    wait_wire(expected_num);
+
+    printf("masked %u bytes: %lu dropped\n", (unsigned)sizeof(fill), (unsigned long)UART_GetDropped());
+
+    result |=(UART_GetDropped()!=UART_TX_BUFFER_SIZE);
+    result |=(paced_longest>STALL_LIMIT);
+    result |=(wire_num!=expected_num || memcmp(wire, expected, expected_num));
+
+    pthread_mutex_lock(&transfer_lock);
+    running = false;
+    pthread_cond_signal(&transfer_started);
+    pthread_mutex_unlock(&transfer_lock);
+    pthread_join(uart, NULL);
+
+    printf("%s\n", result ? "mock UART check failed" : "wire matches, paced lines never stalled");
+
+    return result;
+}
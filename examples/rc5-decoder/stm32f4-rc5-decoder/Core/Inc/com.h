@@ -11,10 +11,22 @@
 #include "stm32f4xx_hal.h"
 #include <stdio.h>
 
+#define UART_TX_BUFFER_SIZE		512		// bytes, power of two
+#define UART_LINE_BUFFER_SIZE	64		// bytes, stdio line buffer
+
+// ring indices shared with the TX complete interrupt, a host build where that interrupt is a
+// thread defines this as _Atomic
+#ifndef UART_TX_SHARED
+#define UART_TX_SHARED			volatile
+#endif
+
 int __io_putchar(int);
 int __io_getchar();
+int _write(int, char *, int);
 
 void UART_SetSTDIN(UART_HandleTypeDef *);
 void UART_SetSTDOUT(UART_HandleTypeDef *);
 
+uint32_t UART_GetDropped();
+
 #endif /* SNEAK100_UTILITIES_INC_UART_H_ */
@@ -18,6 +18,8 @@
 #define RC5_TIME_TOLERANCE	444		// us
 #define RC5_TIME_PRESCALER	1		// us/LSB
 
+#define RC5_QUEUE_SIZE		8		// frames, power of two
+
 typedef enum {
 	RC5_STATE_START1,
 	RC5_STATE_MID1,
@@ -36,7 +38,17 @@ typedef union {
 	uint16_t frame;
 } RC5_Message_t;
 
+// single producer (EXTI callback), single consumer (main loop)
+typedef struct {
+	RC5_Message_t buffer[RC5_QUEUE_SIZE];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t dropped;
+} RC5_Queue_t;
+
 typedef struct {
+	RC5_Queue_t queue;
+
 	uint8_t bits_ready;
 	RC5_Message_t message;
 
@@ -52,6 +64,7 @@ typedef struct {
 
 void DecoderRC5_Init(DecoderRC5_t *, TIM_HandleTypeDef *, GPIO_TypeDef *, uint16_t);
 uint8_t DecoderRC5_GetMessage(DecoderRC5_t *, RC5_Message_t *);
+uint32_t DecoderRC5_GetDropped(DecoderRC5_t *);
 
 void DecoderRC5_EXTI_Callback(DecoderRC5_t *, uint16_t);
 void DecoderRC5_PeriodElapsedCallback(DecoderRC5_t *, TIM_HandleTypeDef *);
@@ -60,6 +73,9 @@ void __rc5_emit1(void *);
 void __rc5_emit0(void *);
 void __rc5_reset(void *);
 
+uint8_t __rc5_queue_push(RC5_Queue_t *, RC5_Message_t);
+uint8_t __rc5_queue_pop(RC5_Queue_t *, RC5_Message_t *);
+
 uint8_t __rc5_get_short_space(void *);
 uint8_t __rc5_get_short_pulse(void *);
 uint8_t __rc5_get_long_space(void *);
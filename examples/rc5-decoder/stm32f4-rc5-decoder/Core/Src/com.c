@@ -10,8 +10,91 @@
 static UART_HandleTypeDef *uart_stdin;
 static UART_HandleTypeDef *uart_stdout;
 
+// written by _write (head), drained by the TX complete interrupt (tail)
+static uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static UART_TX_SHARED uint32_t tx_head;
+static UART_TX_SHARED uint32_t tx_tail;
+static UART_TX_SHARED uint32_t tx_pending;
+static UART_TX_SHARED uint32_t tx_dropped;
+
+static char line_buffer[UART_LINE_BUFFER_SIZE];
+
+static void __uart_tx_start() {
+	const uint32_t used = tx_head - tx_tail;
+
+	if(!used) {
+		tx_pending = 0;
+		return;
+	}
+
+	// one transfer per contiguous run, wrapped part goes in the next one
+	const uint32_t offset = tx_tail & (UART_TX_BUFFER_SIZE - 1);
+	uint32_t length = UART_TX_BUFFER_SIZE - offset;
+
+	if(length>used)
+		length = used;
+
+	tx_pending = length;
+
+	HAL_UART_Transmit_IT(uart_stdout, &tx_buffer[offset], length);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+	if(huart!=uart_stdout)
+		return;
+
+	tx_tail += tx_pending;
+
+	__uart_tx_start();
+}
+
+// waits for room while the TX interrupt can drain the ring, with interrupts masked or inside an
+// interrupt it cannot, so whatever does not fit is dropped and counted instead
+int _write(int file, char *ptr, int len) {
+	(void)file;
+
+	int written = 0;
+
+	while(written<len) {
+		const uint32_t space = UART_TX_BUFFER_SIZE - (tx_head - tx_tail);
+
+		if(!space) {
+			if(__get_PRIMASK() || __get_IPSR()) {
+				tx_dropped += len - written;
+				break;
+			}
+
+			continue;
+		}
+
+		uint32_t chunk = len - written;
+
+		if(chunk>space)
+			chunk = space;
+
+		for(uint32_t i=0; i<chunk; i++)
+			tx_buffer[(tx_head + i) & (UART_TX_BUFFER_SIZE - 1)] = ptr[written + i];
+
+		__DMB();
+		tx_head += chunk;
+		written += chunk;
+
+		const uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		if(!tx_pending)
+			__uart_tx_start();
+
+		__set_PRIMASK(primask);
+	}
+
+	return len;
+}
+
 int __io_putchar(int ch) {
-	HAL_UART_Transmit(uart_stdout, (uint8_t*)&ch, 1, HAL_MAX_DELAY);
+	char c = ch;
+
+	_write(1, &c, 1);
 	return ch;
 }
 
@@ -32,5 +115,10 @@ void UART_SetSTDIN(UART_HandleTypeDef *huart) {
 void UART_SetSTDOUT(UART_HandleTypeDef *huart) {
 	uart_stdout = huart;
 
-	setvbuf(stdout, NULL, _IONBF, 0);
+	// whole lines reach _write in one call
+	setvbuf(stdout, line_buffer, _IOLBF, sizeof(line_buffer));
+}
+
+uint32_t UART_GetDropped() {
+	return tx_dropped;
 }
@@ -107,13 +107,21 @@ int main(void)
 
   DecoderRC5_Init(&decoder, &htim11, RECEIVER_GPIO_Port, RECEIVER_Pin);
 
+  uint32_t dropped = 0;
+
   while(1) {
 
 	  RC5_Message_t message;
 
-	  if(DecoderRC5_GetMessage(&decoder, &message)) {
+	  if(DecoderRC5_GetDropped(&decoder)!=dropped) {
+		  dropped = DecoderRC5_GetDropped(&decoder);
+
+		  printf("Dropped frames: %lu\r\n", dropped);
+	  }
+
+	  while(DecoderRC5_GetMessage(&decoder, &message)) {
 
-		  printf("Toggle: %u Address: 0x%02X Command: 0x%02X\n\r",
+		  printf("Toggle: %u Address: 0x%02X Command: 0x%02X\r\n",
 				  message.toggle,
 				  message.address,
 				  message.command
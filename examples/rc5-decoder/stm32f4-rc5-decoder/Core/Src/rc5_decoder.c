@@ -36,23 +36,17 @@ void DecoderRC5_Init(DecoderRC5_t *decoder, TIM_HandleTypeDef *htim, GPIO_TypeDe
 }
 
 uint8_t DecoderRC5_GetMessage(DecoderRC5_t *decoder, RC5_Message_t *message) {
-	if(decoder->bits_ready!=14)
-		return 0;
-
-	*message = decoder->message;
-
-	FiniteStateMachine_Start(&decoder->fsm, RC5_STATE_RESET);
+	return __rc5_queue_pop(&decoder->queue, message);
+}
 
-	return 1;
+uint32_t DecoderRC5_GetDropped(DecoderRC5_t *decoder) {
+	return decoder->queue.dropped;
 }
 
 void DecoderRC5_PeriodElapsedCallback(DecoderRC5_t *decoder, TIM_HandleTypeDef *htim) {
 	if(htim->Instance!=decoder->timer->Instance)
 		return;
 
-	if(decoder->bits_ready==14)
-		return;
-
 	FiniteStateMachine_Start(&decoder->fsm, RC5_STATE_RESET);
 }
 
@@ -60,14 +54,18 @@ void DecoderRC5_EXTI_Callback(DecoderRC5_t *decoder, uint16_t GPIO_Pin) {
 	if(GPIO_Pin!=decoder->rx_pin)
 		return;
 
-	if(decoder->bits_ready==14)
-		return;
-
 	decoder->state = !HAL_GPIO_ReadPin(decoder->rx_port, decoder->rx_pin);
 	decoder->counter = __HAL_TIM_GET_COUNTER(decoder->timer);
 
 	__HAL_TIM_SET_COUNTER(decoder->timer, 0);
 
 	FiniteStateMachine_Update(&decoder->fsm);
+
+	// hand the frame over and restart immediately, next edge may belong to the next frame
+	if(decoder->bits_ready==14) {
+		__rc5_queue_push(&decoder->queue, decoder->message);
+
+		FiniteStateMachine_Start(&decoder->fsm, RC5_STATE_RESET);
+	}
 }
 
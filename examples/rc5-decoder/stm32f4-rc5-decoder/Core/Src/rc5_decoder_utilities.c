@@ -22,11 +22,44 @@ void __rc5_reset(void *decoder) {
 	((DecoderRC5_t *)decoder)->bits_ready = 0;
 }
 
+uint8_t __rc5_queue_push(RC5_Queue_t *queue, RC5_Message_t message) {
+	const uint32_t head = queue->head;
+
+	if(head - queue->tail==RC5_QUEUE_SIZE) {
+		queue->dropped++;
+		return 0;
+	}
+
+	queue->buffer[head & (RC5_QUEUE_SIZE - 1)] = message;
+
+	// frame must be visible before the consumer sees the new head
+	__DMB();
+	queue->head = head + 1;
+
+	return 1;
+}
+
+uint8_t __rc5_queue_pop(RC5_Queue_t *queue, RC5_Message_t *message) {
+	const uint32_t tail = queue->tail;
+
+	if(queue->head==tail)
+		return 0;
+
+	__DMB();
+	*message = queue->buffer[tail & (RC5_QUEUE_SIZE - 1)];
+
+	// slot must be read before the producer may overwrite it
+	__DMB();
+	queue->tail = tail + 1;
+
+	return 1;
+}
+
 uint8_t __rc5_get_short_space(void *decoder) {
 	if(((DecoderRC5_t *)decoder)->state) {
 		uint32_t time = ((DecoderRC5_t *)decoder)->counter*RC5_TIME_PRESCALER;
 
-		if(abs(time - RC5_TIME_SHORT)<=RC5_TIME_TOLERANCE)
+		if(abs((int32_t)time - RC5_TIME_SHORT)<=RC5_TIME_TOLERANCE)
 			return 1;
 	}
 
@@ -37,7 +70,7 @@ uint8_t __rc5_get_short_pulse(void *decoder) {
 	if(!((DecoderRC5_t *)decoder)->state) {
 		uint32_t time = ((DecoderRC5_t *)decoder)->counter*RC5_TIME_PRESCALER;
 
-		if(abs(time - RC5_TIME_SHORT)<=RC5_TIME_TOLERANCE)
+		if(abs((int32_t)time - RC5_TIME_SHORT)<=RC5_TIME_TOLERANCE)
 			return 1;
 	}
 
@@ -48,7 +81,7 @@ uint8_t __rc5_get_long_space(void *decoder) {
 	if(((DecoderRC5_t *)decoder)->state) {
 		uint32_t time = ((DecoderRC5_t *)decoder)->counter*RC5_TIME_PRESCALER;
 
-		if(abs(time - RC5_TIME_LONG)<=RC5_TIME_TOLERANCE)
+		if(abs((int32_t)time - RC5_TIME_LONG)<=RC5_TIME_TOLERANCE)
 			return 1;
 	}
 
@@ -59,7 +92,7 @@ uint8_t __rc5_get_long_pulse(void *decoder) {
 	if(!((DecoderRC5_t *)decoder)->state) {
 		uint32_t time = ((DecoderRC5_t *)decoder)->counter*RC5_TIME_PRESCALER;
 
-		if(abs(time - RC5_TIME_LONG)<=RC5_TIME_TOLERANCE)
+		if(abs((int32_t)time - RC5_TIME_LONG)<=RC5_TIME_TOLERANCE)
 			return 1;
 	}
 
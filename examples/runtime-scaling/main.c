@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fsm/fsm.h"
+#include "fsm/runtime.h"
+
+// every instance toggles between two states and notifies itself until its budget is spent,
+// a tenth of the instances stay idle and must not cost anything
+
+enum {
+    LIGHT_ON,
+    LIGHT_OFF
+};
+
+typedef struct {
+    fsm_runtime_t *runtime;
+    uint32_t id;
+    uint32_t remaining;
+    uint32_t hash;
+    uint32_t steps;
+} example_data_t;
+
+static bool trigger_toggle(const void *context) {
+    return ((const example_data_t *)context)->remaining & 1;
+}
+
+// some work per step, so the benchmark is not all scheduling
+static void execute_state(void *context) {
+    example_data_t *data = (example_data_t *)context;
+
+    for(int i=0; i<64; i++) {
+        data->hash = data->hash*1103515245 + 12345;
+    }
+
+    data->steps++;
+
+    if(data->remaining) {
+        data->remaining--;
+        fsm_runtime_notify(data->runtime, data->id);
+    }
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t instances_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000;
+    const uint32_t steps_num = (argc>2) ? strtoul(argv[2], NULL, 10) : 100;
+    const unsigned int threads_max = (argc>3) ? strtoul(argv[3], NULL, 10) : (unsigned int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    fsm_t *machines = malloc(instances_num*sizeof(fsm_t));
+    example_data_t *data = malloc(instances_num*sizeof(example_data_t));
+
+    if(!machines || !data) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for(uint32_t i=0; i<instances_num; i++) {
+        machines[i] = (fsm_t){
+            .context = &data[i]
+        };
+
+        fsm_add_state(&machines[i], LIGHT_ON,   NULL, execute_state, NULL);
+        fsm_add_state(&machines[i], LIGHT_OFF,  NULL, execute_state, NULL);
+
+        fsm_add_transition(&machines[i], LIGHT_ON,  LIGHT_OFF,  trigger_toggle, NULL);
+        fsm_add_transition(&machines[i], LIGHT_OFF, LIGHT_ON,   trigger_toggle, NULL);
+
+        fsm_start(&machines[i], LIGHT_OFF);
+    }
+
+    printf("%u instances, %u steps each, 1 in 10 idle\n", instances_num, steps_num);
+
+    double single_rate = 0;
+
+    for(unsigned int threads=1; threads<=threads_max; threads*=2) {
+        fsm_runtime_t runtime;
+        uint64_t expected = 0;
+
+        if(!fsm_runtime_init(&runtime, instances_num, NULL, NULL)) {
+            printf("out of memory\n");
+            return 1;
+        }
+
+        for(uint32_t i=0; i<instances_num; i++) {
+            data[i] = (example_data_t){&runtime, fsm_runtime_add(&runtime, &machines[i]), steps_num, i, 0};
+        }
+
+        const uint64_t start = now_ns();
+
+        if(!fsm_runtime_start(&runtime, threads)) {
+            printf("cannot start %u workers\n", threads);
+            fsm_runtime_stop(&runtime);
+            return 1;
+        }
+
+        for(uint32_t i=0; i<instances_num; i++) {
+            if(i%10) {
+                fsm_runtime_notify(&runtime, data[i].id);
+                expected +=steps_num + 1;
+            }
+        }
+
+        fsm_runtime_wait_idle(&runtime);
+
+        const uint64_t elapsed_ns = now_ns() - start;
+        uint64_t steals = 0;
+        uint64_t steps = 0;
+
+        for(unsigned int i=0; i<threads; i++) {
+            steals +=runtime.workers[i].steals;
+        }
+
+        for(uint32_t i=0; i<instances_num; i++) {
+            steps +=data[i].steps;
+        }
+
+        fsm_runtime_stop(&runtime);
+
+        const double rate = steps*1e3/elapsed_ns;
+
+        if(threads==1) {
+            single_rate = rate;
+        }
+
+        printf("%3u threads %8.2f M steps/s  x%.2f  %llu steals\n", threads, rate, rate/single_rate, (unsigned long long)steals);
+
+        if(steps!=expected) {
+            printf("lost steps: %llu of %llu\n", (unsigned long long)steps, (unsigned long long)expected);
+            return 1;
+        }
+    }
+
+    free(machines);
+    free(data);
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/seqlock.h"
+
+// a writer toggles one machine between two states while a reader takes snapshots as fast as it
+// can; every snapshot must be consistent (state parity equals transitions parity, counters never
+// go back); the writer cost of publishing is reported against plain fsm_update() and the
+// clock_gettime() it includes, first with no reader, then with the reader pinned to another
+// core; with one core the reader shares it, that run only checks the snapshots
+
+typedef struct {
+    fsm_seqlock_t *seqlock;
+    atomic_bool done;
+    uint64_t reads;
+    uint64_t torn;
+} reader_t;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// first two cpus this process may run on, false when there is only one
+static bool pick_cpus(int *writer_cpu, int *reader_cpu) {
+    cpu_set_t allowed;
+    int found = 0;
+
+    if(sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        return false;
+    }
+
+    for(int cpu=0; cpu<CPU_SETSIZE && found<2; cpu++) {
+        if(CPU_ISSET(cpu, &allowed)) {
+            *(found++ ? reader_cpu : writer_cpu) = cpu;
+        }
+    }
+
+    return found==2;
+}
+
+static bool pin(pthread_t thread, int cpu) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return !pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+static double time_published(fsm_seqlock_t *seqlock, uint32_t updates_num) {
+    const uint64_t start = now_ns();
+
+    for(uint32_t i=0; i<updates_num; i++) {
+        fsm_seqlock_update(seqlock);
+    }
+
+    return (double)(now_ns() - start)/updates_num;
+}
+
+static void * run_reader(void *arg) {
+    reader_t *reader = arg;
+    struct fsm_snapshot snapshot;
+    struct fsm_snapshot last = {0};
+
+    while(!atomic_load_explicit(&reader->done, memory_order_relaxed)) {
+        fsm_seqlock_read(reader->seqlock, &snapshot);
+
+        if(snapshot.state!=(snapshot.transitions & 1) || snapshot.transitions<last.transitions
+            || snapshot.entered_ns<last.entered_ns) {
+            reader->torn++;
+        }
+
+        last = snapshot;
+        reader->reads++;
+    }
+
+    return NULL;
+}
+
+static void setup(fsm_t *fsm) {
+    *fsm = (fsm_t){0};
+
+    fsm_add_state(fsm, 0, NULL, NULL, NULL);
+    fsm_add_state(fsm, 1, NULL, NULL, NULL);
+    fsm_add_transition(fsm, 0, 1, NULL, NULL);
+    fsm_add_transition(fsm, 1, 0, NULL, NULL);
+
+    fsm_start(fsm, 0);
+}
+
+int main(int argc, char **argv) {
+    const uint32_t updates_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    fsm_t fsm;
+    fsm_seqlock_t seqlock;
+    reader_t reader = {.seqlock = &seqlock};
+    pthread_t thread;
+    struct fsm_snapshot snapshot;
+    int writer_cpu;
+    int reader_cpu;
+    volatile uint64_t sink = 0;
+
+    setup(&fsm);
+
+    uint64_t start = now_ns();
+
+    for(uint32_t i=0; i<updates_num; i++) {
+        fsm_update(&fsm);
+    }
+
+    const double plain = (double)(now_ns() - start)/updates_num;
+
+    start = now_ns();
+
+    for(uint32_t i=0; i<updates_num; i++) {
+        sink +=now_ns();
+    }
+
+    const double clock = (double)(now_ns() - start)/updates_num;
+
+    // no reader, the publish alone
+    setup(&fsm);
+    fsm_seqlock_init(&seqlock, &fsm);
+
+    const double alone = time_published(&seqlock, updates_num);
+
+    // a reader polling from another core, or sharing this one
+    const bool two_cpus = pick_cpus(&writer_cpu, &reader_cpu) && pin(pthread_self(), writer_cpu);
+
+    setup(&fsm);
+    fsm_seqlock_init(&seqlock, &fsm);
+    atomic_init(&reader.done, false);
+
+    if(pthread_create(&thread, NULL, run_reader, &reader)) {
+        printf("cannot create the reader\n");
+        return 1;
+    }
+
+    const bool pinned = two_cpus && pin(thread, reader_cpu);
+    const double read = time_published(&seqlock, updates_num);
+
+    atomic_store(&reader.done, true);
+    pthread_join(thread, NULL);
+
+    fsm_seqlock_read(&seqlock, &snapshot);
+
+    printf("fsm_update           %8.2f ns/update\n", plain);
+    printf("clock_gettime        %8.2f ns/call\n", clock);
+    printf("fsm_seqlock_update   %8.2f ns/update (+%.2f) with no reader\n", alone, alone - plain);
+
+    if(pinned) {
+        printf("fsm_seqlock_update   %8.2f ns/update (+%.2f) with a reader on cpu %d, writer on cpu %d\n", read,
+            read - plain, reader_cpu, writer_cpu);
+    } else {
+        printf("one cpu, the reader shares it and its run is not timed\n");
+    }
+
+    printf("%llu reads, %llu inconsistent, last %llu transitions in state %u\n", (unsigned long long)reader.reads,
+        (unsigned long long)reader.torn, (unsigned long long)snapshot.transitions, snapshot.state);
+
+    return (reader.torn || snapshot.transitions!=updates_num) ? 1 : 0;
+}
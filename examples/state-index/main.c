@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/message.h"
+#include "fsm/pool.h"
+
+// a million sessions spread over four states, a small share of them idle; counting and waking
+// the idle ones through the per-state bitmaps is compared with a scan over every instance;
+// waking has to touch the entry and the session of every idle instance either way, a cache
+// miss each: the scan waits on them one by one on top of reading every entry, the broadcast
+// requests them a batch at a time, which is most of its lead at 1% idle; the speedups are
+// printed, not checked, single wall-clock ratios vary with the machine and its load, only
+// disagreement between index and scan fails the run
+
+enum {
+    STATE_IDLE,
+    STATE_ACTIVE,
+    STATE_CLOSING,
+    STATE_CLOSED,
+    STATES_NUM
+};
+
+enum {
+    EVENT_NONE,
+    EVENT_WAKE,
+    EVENT_ADVANCE
+};
+
+typedef struct {
+    struct fsm_message message;
+    uint32_t wakes;
+} session_t;
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void) {
+    seed ^=seed << 13;
+    seed ^=seed >> 17;
+    seed ^=seed << 5;
+
+    return seed;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static bool trigger_wake(const void *context) {
+    return ((const session_t *)context)->message.event==EVENT_WAKE;
+}
+
+static bool trigger_advance(const void *context) {
+    return ((const session_t *)context)->message.event==EVENT_ADVANCE;
+}
+
+static void enter_active(void *context) {
+    ((session_t *)context)->wakes++;
+}
+
+static void count_visit(fsm_handle_t handle, void *context, uint8_t state, void *arg) {
+    (void)handle;
+    (void)context;
+    (void)state;
+
+    (*(uint32_t *)arg)++;
+}
+
+// one in one_in sessions stays idle, the rest are spread over the other states
+static void setup(fsm_pool_t *pool, const struct fsm_frozen *frozen, session_t *sessions, uint32_t instances_num, uint32_t one_in) {
+    fsm_pool_init(pool, frozen, instances_num);
+    seed = 1;
+
+    for(uint32_t i=0; i<instances_num; i++) {
+        sessions[i] = (session_t){0};
+
+        const fsm_handle_t handle = fsm_pool_create(pool, &sessions[i], STATE_IDLE);
+        const uint32_t roll = next_random()%one_in;
+
+        sessions[i].message.event = EVENT_ADVANCE;
+
+        for(uint32_t step=0; step<(roll ? 1 + roll%3 : 0); step++) {
+            fsm_pool_update(pool, handle);
+        }
+
+        sessions[i].message.event = EVENT_NONE;
+    }
+}
+
+// returns nonzero when index and scan disagree
+static int check_share(const struct fsm_frozen *frozen, uint32_t instances_num, uint32_t one_in) {
+    fsm_pool_t indexed;
+    fsm_pool_t scanned;
+    session_t *indexed_sessions = malloc(instances_num*sizeof(session_t));
+    session_t *scanned_sessions = malloc(instances_num*sizeof(session_t));
+
+    if(!indexed_sessions || !scanned_sessions) {
+        printf("out of memory\n");
+        free(indexed_sessions);
+        free(scanned_sessions);
+        return 1;
+    }
+
+    setup(&indexed, frozen, indexed_sessions, instances_num, one_in);
+    setup(&scanned, frozen, scanned_sessions, instances_num, one_in);
+
+    // count
+    uint64_t start = now_ns();
+    const uint32_t idle = fsm_pool_count(&indexed, STATE_IDLE);
+    const uint64_t count_indexed = now_ns() - start;
+
+    start = now_ns();
+    uint32_t idle_scanned = 0;
+
+    for(uint32_t i=0; i<scanned.instances_num; i++) {
+        idle_scanned +=(frozen->cold[scanned.entries[i].index].id==STATE_IDLE);
+    }
+
+    const uint64_t count_scanned = now_ns() - start;
+
+    // broadcast
+    start = now_ns();
+    const uint32_t woken = fsm_pool_broadcast(&indexed, STATE_IDLE, EVENT_WAKE, NULL);
+    const uint64_t broadcast_indexed = now_ns() - start;
+
+    start = now_ns();
+    uint32_t woken_scanned = 0;
+
+    for(uint32_t i=0; i<scanned.instances_num; i++) {
+        struct fsm_pool_entry *entry = &scanned.entries[i];
+
+        if(frozen->cold[entry->index].id==STATE_IDLE) {
+            ((session_t *)entry->context)->message.event = EVENT_WAKE;
+            fsm_frozen_update(frozen, &entry->index, entry->context);
+            woken_scanned++;
+        }
+    }
+
+    const uint64_t broadcast_scanned = now_ns() - start;
+    const double speedup = (double)broadcast_scanned/(broadcast_indexed ? broadcast_indexed : 1);
+
+    printf("%u instances, %u idle\n", instances_num, idle);
+    printf("count      index %10.3f ms  scan %10.3f ms\n", count_indexed/1e6, count_scanned/1e6);
+    printf("broadcast  index %10.3f ms  scan %10.3f ms  %.1fx\n", broadcast_indexed/1e6, broadcast_scanned/1e6,
+        speedup);
+
+    int result = (idle!=idle_scanned || woken!=idle || woken_scanned!=idle || fsm_pool_count(&indexed, STATE_IDLE));
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        uint32_t members = 0;
+
+        for(fsm_handle_t h=fsm_pool_first(&indexed, s); h!=FSM_POOL_NONE; h=fsm_pool_next(&indexed, h)) {
+            uint8_t state;
+
+            result |=(!fsm_pool_state(&indexed, h, &state) || state!=s);
+            members++;
+        }
+
+        result |=(members!=fsm_pool_count(&indexed, s));
+    }
+
+    for(uint32_t i=0; i<instances_num; i++) {
+        result |=(indexed_sessions[i].wakes!=scanned_sessions[i].wakes);
+    }
+
+    // ids the machine does not have are empty states
+    uint32_t visited = 0;
+
+    for(uint16_t id=STATES_NUM; id<256; id++) {
+        fsm_pool_each_in(&indexed, id, count_visit, &visited);
+        result |=(fsm_pool_count(&indexed, id)!=0 || fsm_pool_first(&indexed, id)!=FSM_POOL_NONE
+            || fsm_pool_broadcast(&indexed, id, EVENT_WAKE, NULL)!=0);
+    }
+
+    result |=(visited!=0);
+
+    printf("%s\n", result ? "index and scan disagree" : "index and scan agree");
+
+    fsm_pool_free(&indexed);
+    fsm_pool_free(&scanned);
+    free(indexed_sessions);
+    free(scanned_sessions);
+
+    return result;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t instances_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    static fsm_t definition;
+
+    fsm_add_state(&definition, STATE_IDLE, NULL, NULL, NULL);
+    fsm_add_state(&definition, STATE_ACTIVE, enter_active, NULL, NULL);
+    fsm_add_state(&definition, STATE_CLOSING, NULL, NULL, NULL);
+    fsm_add_state(&definition, STATE_CLOSED, NULL, NULL, NULL);
+    fsm_add_transition(&definition, STATE_IDLE, STATE_ACTIVE, trigger_wake, NULL);
+    fsm_add_transition(&definition, STATE_IDLE, STATE_ACTIVE, trigger_advance, NULL);
+    fsm_add_transition(&definition, STATE_ACTIVE, STATE_CLOSING, trigger_advance, NULL);
+    fsm_add_transition(&definition, STATE_CLOSING, STATE_CLOSED, trigger_advance, NULL);
+
+    const size_t size = fsm_freeze(&definition, NULL, 0);
+    void *frozen = malloc(size);
+
+    if(!frozen) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    fsm_freeze(&definition, frozen, size);
+
+    int result = check_share(definition.frozen, instances_num, 100);
+    result |=check_share(definition.frozen, instances_num, 1000);
+
+    free(frozen);
+
+    return result;
+}
@@ -0,0 +1,201 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/stream.h"
+
+// a small tokenizer built twice from one transition list: as a byte stream and as an fsm_t
+// fed one byte per fsm_update(), actions fold their id and the byte offset into a trace
+
+enum {
+    BLANK,
+    WORD,
+    NUMBER,
+    BAD,
+    STATES_NUM
+};
+
+struct scan {
+    const uint8_t *base;
+    size_t position;
+    uint8_t byte;
+    uint64_t trace;
+};
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static void record(struct scan *scan, uint8_t id, size_t position) {
+    scan->trace = scan->trace*31 + id*1000003 + position;
+}
+
+#define RANGE_TRIGGER(name, first, last) \
+    static bool name(const void *context) { \
+        const uint8_t byte = ((const struct scan *)context)->byte; \
+        return byte>=first && byte<=last; \
+    }
+
+RANGE_TRIGGER(is_lower, 'a', 'z')
+RANGE_TRIGGER(is_upper, 'A', 'Z')
+RANGE_TRIGGER(is_digit, '0', '9')
+RANGE_TRIGGER(is_space, ' ', ' ')
+RANGE_TRIGGER(is_newline, '\n', '\n')
+RANGE_TRIGGER(is_dot, '.', '.')
+RANGE_TRIGGER(is_x, 'x', 'x')
+
+#define ACTION(name, id) \
+    static void name##_stream(void *context, const uint8_t *byte) { \
+        struct scan *scan = context; \
+        record(scan, id, byte - scan->base); \
+    } \
+    static void name##_update(void *context) { \
+        struct scan *scan = context; \
+        record(scan, id, scan->position); \
+    }
+
+ACTION(word, 1)
+ACTION(number, 2)
+ACTION(line, 3)
+ACTION(bad, 4)
+
+struct transition {
+    uint8_t from;
+    uint8_t to;
+    uint8_t first;
+    uint8_t last;
+    fsm_trigger_t trigger;
+    fsm_stream_action_t stream_action;
+    fsm_callback_t update_action;
+};
+
+// first match wins in both forms so BLANK on 'x' is a word, bytes without a transition keep the state
+static const struct transition transitions[] = {
+    {BLANK, WORD, 'a', 'z', is_lower, word_stream, word_update},
+    {BLANK, WORD, 'A', 'Z', is_upper, word_stream, word_update},
+    {BLANK, NUMBER, '0', '9', is_digit, number_stream, number_update},
+    {BLANK, BLANK, '\n', '\n', is_newline, line_stream, line_update},
+    {BLANK, BAD, 'x', 'x', is_x, bad_stream, bad_update},
+    {WORD, BLANK, ' ', ' ', is_space, NULL, NULL},
+    {WORD, BLANK, '\n', '\n', is_newline, line_stream, line_update},
+    {WORD, WORD, '0', '9', is_digit, NULL, NULL},
+    {NUMBER, BLANK, ' ', ' ', is_space, NULL, NULL},
+    {NUMBER, BLANK, '\n', '\n', is_newline, line_stream, line_update},
+    {NUMBER, BAD, 'a', 'z', is_lower, bad_stream, bad_update},
+    {NUMBER, NUMBER, '.', '.', is_dot, NULL, NULL},
+    {BAD, BLANK, ' ', ' ', is_space, NULL, NULL},
+    {BAD, BLANK, '\n', '\n', is_newline, line_stream, line_update},
+};
+
+#define TRANSITIONS_NUM (sizeof(transitions)/sizeof(transitions[0]))
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// feeds in random chunk sizes so the state has to carry across calls
+static uint64_t feed_chunks(fsm_stream_t *stream, const uint8_t *input, size_t len) {
+    const uint64_t start = now_ns();
+
+    for(size_t offset=0; offset<len;) {
+        size_t chunk = 1 + random_next()%65536;
+
+        if(chunk>len - offset) {
+            chunk = len - offset;
+        }
+
+        fsm_feed(stream, &input[offset], chunk);
+        offset +=chunk;
+    }
+
+    return now_ns() - start;
+}
+
+int main(int argc, char **argv) {
+    const size_t len = ((argc>1) ? strtoul(argv[1], NULL, 10) : 16) << 20;
+
+    // text-like input with a few bytes no transition knows about
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEZ0123456789      ..\n\n,;-\t";
+    uint8_t *input = malloc(len);
+
+    if(!input) {
+        return 1;
+    }
+
+    for(size_t i=0; i<len; i++) {
+        input[i] = alphabet[random_next()%(sizeof(alphabet) - 1)];
+    }
+
+    static fsm_stream_t stream, recognizer;
+    static fsm_t reference;
+    struct scan stream_scan = {.base = input}, reference_scan = {.base = input};
+
+    stream.context = &stream_scan;
+    reference.context = &reference_scan;
+
+    for(uint8_t s=0; s<STATES_NUM; s++) {
+        fsm_add_state(&reference, s, NULL, NULL, NULL);
+    }
+
+    for(size_t i=0; i<TRANSITIONS_NUM; i++) {
+        const struct transition *t = &transitions[i];
+
+        fsm_stream_add_transition(&stream, t->from, t->to, t->first, t->last, t->stream_action);
+        fsm_stream_add_transition(&recognizer, t->from, t->to, t->first, t->last, NULL);
+        fsm_add_transition(&reference, t->from, t->to, t->trigger, t->update_action);
+    }
+
+    if(!fsm_stream_compile(&stream) || !fsm_stream_compile(&recognizer)) {
+        printf("byte classes do not fit FSM_STREAM_CLASS_MAX_NUM\n");
+        return 1;
+    }
+
+#ifdef FSM_STREAM_BYTE_CLASSES
+    printf("%zu bytes, %u byte classes\n", len, stream.classes_num);
+#else
+    printf("%zu bytes, rows indexed by byte\n", len);
+#endif
+
+    fsm_start(&reference, BLANK);
+
+    uint64_t start = now_ns();
+    for(size_t i=0; i<len; i++) {
+        reference_scan.position = i;
+        reference_scan.byte = input[i];
+        fsm_update(&reference);
+    }
+    const uint64_t reference_ns = now_ns() - start;
+
+    fsm_stream_start(&stream, BLANK);
+    const uint64_t stream_ns = feed_chunks(&stream, input, len);
+
+    fsm_stream_start(&recognizer, BLANK);
+    const uint64_t recognizer_ns = feed_chunks(&recognizer, input, len);
+
+    printf("fsm_update   %8.3f GB/s\n", (double)len/reference_ns);
+    printf("actions      %8.3f GB/s\n", (double)len/stream_ns);
+    printf("recognizer   %8.3f GB/s\n", (double)len/recognizer_ns);
+
+    if(stream_scan.trace!=reference_scan.trace || stream.current!=reference.current->id
+        || recognizer.current!=reference.current->id) {
+        printf("stream differs from fsm_update\n");
+        return 1;
+    }
+
+    printf("stream matches fsm_update\n");
+
+    free(input);
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/table.h"
+
+// one machine with a large, mostly empty event alphabet built in every layout,
+// each state reacts to a few events clustered around its own offset like parser tables do
+
+static const char *names[] = {"auto", "dense", "sparse", "comb", "hash"};
+
+// a dense table bigger than this is not built
+#define DENSE_MAX_BYTES ((size_t)1<<28)
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+static void count(void *context) {
+    (*(uint64_t *)context)++;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const unsigned long states_arg = (argc>1) ? strtoul(argv[1], NULL, 10) : 1024;
+    const unsigned long events_arg = (argc>2) ? strtoul(argv[2], NULL, 10) : 4096;
+    const unsigned long per_state_arg = (argc>3) ? strtoul(argv[3], NULL, 10) : 8;
+    const size_t dispatches_num = (argc>4) ? strtoul(argv[4], NULL, 10) : 10000000;
+
+    // ids up to FSM_TABLE_NONE are taken, the rest is used as a divisor
+    if(!states_arg || states_arg>=FSM_TABLE_NONE || !events_arg || events_arg>=FSM_TABLE_NONE
+        || !per_state_arg || per_state_arg>=FSM_TABLE_NONE || !dispatches_num) {
+        printf("states, events, transitions per state and dispatches must be positive, ids below %u\n", FSM_TABLE_NONE);
+        return 1;
+    }
+
+    const uint16_t states_num = states_arg;
+    const uint16_t events_num = events_arg;
+    const uint16_t per_state = per_state_arg;
+
+    uint16_t *targets = malloc((size_t)states_num*per_state*sizeof(uint16_t));
+    uint16_t *events = malloc((size_t)states_num*per_state*sizeof(uint16_t));
+
+    for(uint32_t s=0; s<states_num; s++) {
+        const uint16_t offset = random_next()%events_num;
+
+        for(uint32_t j=0; j<per_state; j++) {
+            targets[s*per_state + j] = random_next()%states_num;
+            events[s*per_state + j] = (offset + random_next()%64)%events_num;
+        }
+    }
+
+    uint64_t counters[5] = {0};
+    fsm_table_t tables[5] = {{0}};
+    const bool skip_dense = (size_t)states_num*events_num*sizeof(struct fsm_table_cell)>DENSE_MAX_BYTES;
+
+    for(int layout=FSM_TABLE_AUTO; layout<=FSM_TABLE_HASH; layout++) {
+        fsm_table_t *table = &tables[layout];
+
+        if(layout==FSM_TABLE_DENSE && skip_dense) {
+            continue;
+        }
+
+        table->context = &counters[layout];
+
+        for(uint32_t s=0; s<states_num; s++) {
+            fsm_table_add_state(table, s, count, NULL, NULL);
+        }
+
+        for(uint32_t s=0; s<states_num; s++) {
+            for(uint32_t j=0; j<per_state; j++) {
+                fsm_table_add_transition(table, s, targets[s*per_state + j], events[s*per_state + j], (j & 1) ? count : NULL);
+            }
+        }
+
+        fsm_table_build_layout(table, layout);
+    }
+
+    // mostly events the current state reacts to, one in eight from the whole alphabet
+    uint16_t *inputs = malloc(dispatches_num*sizeof(uint16_t));
+    uint16_t current = 0;
+
+    for(size_t i=0; i<dispatches_num; i++) {
+        if(random_next()%8) {
+            const uint32_t j = random_next()%per_state;
+
+            inputs[i] = events[current*per_state + j];
+        } else {
+            inputs[i] = random_next()%events_num;
+        }
+
+        // follows the first transition added for the event, as the tables do
+        for(uint32_t j=0; j<per_state; j++) {
+            if(events[current*per_state + j]==inputs[i]) {
+                current = targets[current*per_state + j];
+                break;
+            }
+        }
+    }
+
+    printf("%u states, %u events, %u transitions per state\n", states_num, events_num, per_state);
+
+    for(int layout=FSM_TABLE_AUTO; layout<=FSM_TABLE_HASH; layout++) {
+        fsm_table_t *table = &tables[layout];
+
+        if(layout==FSM_TABLE_DENSE && skip_dense) {
+            printf("%-6s    skipped\n", names[layout]);
+            continue;
+        }
+
+        fsm_table_start(table, 0);
+
+        const uint64_t start = now_ns();
+        for(size_t i=0; i<dispatches_num; i++) {
+            fsm_table_dispatch(table, inputs[i]);
+        }
+        const uint64_t elapsed_ns = now_ns() - start;
+
+        printf("%-6s -> %-6s %10zu bytes %8.2f ns/dispatch\n", names[layout], names[table->layout],
+            fsm_table_bytes(table), (double)elapsed_ns/dispatches_num);
+    }
+
+    for(int layout=FSM_TABLE_DENSE; layout<=FSM_TABLE_HASH; layout++) {
+        if(layout==FSM_TABLE_DENSE && skip_dense) {
+            continue;
+        }
+
+        if(counters[layout]!=counters[FSM_TABLE_AUTO] || tables[layout].current!=current) {
+            printf("layouts differ\n");
+            return 1;
+        }
+    }
+
+    printf("layouts match\n");
+
+    for(int layout=FSM_TABLE_AUTO; layout<=FSM_TABLE_HASH; layout++) {
+        fsm_table_free(&tables[layout]);
+    }
+
+    free(targets);
+    free(events);
+    free(inputs);
+
+    return 0;
+}
@@ -0,0 +1,370 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef __linux__
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+#endif
+
+#include "fsm/threaded.h"
+
+// a random machine over an 8 symbol alphabet driven by fsm_update() and by the threaded
+// interpreter with the same symbol stream, every callback folds its tag and the current
+// state into a trace so both must run the same callbacks in the same states; first one
+// event per update, then run to completion where every transition consumes a symbol and
+// fsm_threaded_run() goes through the whole stream in a few calls while fsm_update() is
+// called once per transition; branch mispredictions are counted where perf events are
+// available and both ratios are printed, whichever way they go
+
+#define SYMBOLS_NUM 8
+
+struct run {
+    const fsm_t *fsm;
+    uint8_t symbol;
+    uint64_t trace;
+
+    // run to completion only, the symbol after the stream is SYMBOLS_NUM
+    const uint8_t *cursor;
+};
+
+struct branches {
+    int misses_fd;
+    int total_fd;
+    uint64_t misses;
+    uint64_t total;
+};
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void) {
+    seed = seed*1103515245 + 12345;
+
+    return seed>>8;
+}
+
+#define SYMBOL_TRIGGER(k) \
+    static bool on_##k(const void *context) { \
+        return ((const struct run *)context)->symbol==k; \
+    }
+
+SYMBOL_TRIGGER(0)
+SYMBOL_TRIGGER(1)
+SYMBOL_TRIGGER(2)
+SYMBOL_TRIGGER(3)
+SYMBOL_TRIGGER(4)
+SYMBOL_TRIGGER(5)
+SYMBOL_TRIGGER(6)
+SYMBOL_TRIGGER(7)
+
+static const fsm_trigger_t triggers[SYMBOLS_NUM] = {on_0, on_1, on_2, on_3, on_4, on_5, on_6, on_7};
+
+static void record(void *context, uint8_t tag) {
+    struct run *run = context;
+
+    run->trace = run->trace*31 + tag*FSM_STATE_MAX_NUM + run->fsm->current->id;
+}
+
+static void enter(void *context) {
+    record(context, 1);
+}
+
+static void exit_(void *context) {
+    record(context, 2);
+}
+
+static void action(void *context) {
+    record(context, 3);
+}
+
+static void consume(void *context) {
+    struct run *run = context;
+
+    record(context, 4);
+    run->symbol = *++run->cursor;
+}
+
+static bool on_any(const void *context) {
+    return ((const struct run *)context)->symbol<SYMBOLS_NUM;
+}
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+// every state reacts to a few symbols, every third one also has an unconditional last transition
+static void build(fsm_t *fsm) {
+    for(uint8_t s=0; s<FSM_STATE_MAX_NUM; s++) {
+        fsm_add_state(fsm, s, (s & 1) ? enter : NULL, NULL, (s%3==1) ? exit_ : NULL);
+    }
+
+    for(uint8_t s=0; s<FSM_STATE_MAX_NUM; s++) {
+        const uint8_t events_num = (s%3==0) ? FSM_EVENT_MAX_NUM - 1 : FSM_EVENT_MAX_NUM;
+
+        for(uint8_t j=0; j<events_num; j++) {
+            fsm_add_transition(fsm, s, random_next()%FSM_STATE_MAX_NUM, triggers[random_next()%SYMBOLS_NUM],
+                (j & 1) ? action : NULL);
+        }
+
+        if(s%3==0) {
+            fsm_add_transition(fsm, s, random_next()%FSM_STATE_MAX_NUM, NULL, action);
+        }
+    }
+}
+
+// every transition consumes its symbol and every state takes any symbol in the end, so only
+// the end of the stream stops the machine
+static void build_consuming(fsm_t *fsm) {
+    for(uint8_t s=0; s<FSM_STATE_MAX_NUM; s++) {
+        fsm_add_state(fsm, s, (s & 1) ? enter : NULL, NULL, (s%3==1) ? exit_ : NULL);
+    }
+
+    for(uint8_t s=0; s<FSM_STATE_MAX_NUM; s++) {
+        for(uint8_t j=0; j<FSM_EVENT_MAX_NUM - 1; j++) {
+            fsm_add_transition(fsm, s, random_next()%FSM_STATE_MAX_NUM, triggers[random_next()%SYMBOLS_NUM], consume);
+        }
+
+        fsm_add_transition(fsm, s, random_next()%FSM_STATE_MAX_NUM, on_any, consume);
+    }
+}
+
+#ifdef __linux__
+static int open_counter(uint64_t config) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+// false when the hardware counters are not available, mispredictions are not reported then
+static bool branches_open(struct branches *branches) {
+#ifdef __linux__
+    branches->misses_fd = open_counter(PERF_COUNT_HW_BRANCH_MISSES);
+    branches->total_fd = open_counter(PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+
+    if(branches->misses_fd>=0 && branches->total_fd>=0) {
+        return true;
+    }
+
+    printf("branch counters unavailable (%s), mispredictions not measured\n", strerror(errno));
+
+    if(branches->misses_fd>=0) {
+        close(branches->misses_fd);
+    }
+
+    if(branches->total_fd>=0) {
+        close(branches->total_fd);
+    }
+#else
+    printf("branch counters unavailable on this platform, mispredictions not measured\n");
+#endif
+
+    branches->misses_fd = branches->total_fd = -1;
+
+    return false;
+}
+
+static void branches_start(struct branches *branches) {
+#ifdef __linux__
+    if(branches->misses_fd>=0) {
+        ioctl(branches->misses_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(branches->total_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(branches->misses_fd, PERF_EVENT_IOC_ENABLE, 0);
+        ioctl(branches->total_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)branches;
+#endif
+}
+
+static void branches_stop(struct branches *branches) {
+    branches->misses = branches->total = 0;
+
+#ifdef __linux__
+    if(branches->misses_fd>=0) {
+        ioctl(branches->misses_fd, PERF_EVENT_IOC_DISABLE, 0);
+        ioctl(branches->total_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if(read(branches->misses_fd, &branches->misses, sizeof(uint64_t))!=sizeof(uint64_t)
+            || read(branches->total_fd, &branches->total, sizeof(uint64_t))!=sizeof(uint64_t)) {
+            branches->misses = branches->total = 0;
+        }
+    }
+#endif
+}
+
+static void report(const char *name, uint64_t elapsed_ns, size_t events_num, const struct branches *branches) {
+    printf("%-28s %6.2f ns/event", name, (double)elapsed_ns/events_num);
+
+    if(branches->total) {
+        printf("  %5.2f mispredicts/event  %5.2f%% of %.1f branches/event mispredicted",
+            (double)branches->misses/events_num, 100.0*branches->misses/branches->total,
+            (double)branches->total/events_num);
+    }
+
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const size_t events_num = (argc>1) ? strtoul(argv[1], NULL, 10) : 10000000;
+
+    uint8_t *symbols = malloc(events_num + 1);
+
+    if(!symbols) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    for(size_t i=0; i<events_num; i++) {
+        symbols[i] = random_next()%SYMBOLS_NUM;
+    }
+
+    symbols[events_num] = SYMBOLS_NUM;
+
+    static fsm_t reference, compiled;
+    static fsm_threaded_t threaded;
+    struct run reference_run = {.fsm = &reference}, threaded_run = {.fsm = &compiled};
+
+    uint32_t saved_seed = seed;
+    build(&reference);
+    seed = saved_seed;
+    build(&compiled);
+
+    reference.context = &reference_run;
+    compiled.context = &threaded_run;
+
+    fsm_threaded_compile(&threaded, &compiled);
+
+#ifdef FSM_THREADED_COMPUTED_GOTO
+    printf("computed goto dispatch\n");
+#else
+    printf("switch dispatch\n");
+#endif
+
+    // lockstep pass, every event is compared
+    fsm_start(&reference, 0);
+    fsm_start(&compiled, 0);
+
+    for(size_t i=0; i<events_num; i++) {
+        reference_run.symbol = threaded_run.symbol = symbols[i];
+
+        const bool reference_taken = fsm_update(&reference);
+        const bool threaded_taken = fsm_threaded_update(&threaded);
+
+        if(reference_taken!=threaded_taken || reference.current->id!=compiled.current->id
+            || reference_run.trace!=threaded_run.trace) {
+            printf("traces differ at event %zu\n", i);
+            return 1;
+        }
+    }
+
+    printf("traces match over %zu events\n", events_num);
+
+    struct branches branches;
+
+    branches_open(&branches);
+
+    // timed single step passes, the traces are compared once at the end
+    reference_run.trace = threaded_run.trace = 0;
+
+    fsm_start(&reference, 0);
+    branches_start(&branches);
+    uint64_t start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        reference_run.symbol = symbols[i];
+        fsm_update(&reference);
+    }
+    const uint64_t reference_ns = now_ns() - start;
+    branches_stop(&branches);
+    report("fsm_update", reference_ns, events_num, &branches);
+
+    fsm_start(&compiled, 0);
+    branches_start(&branches);
+    start = now_ns();
+    for(size_t i=0; i<events_num; i++) {
+        threaded_run.symbol = symbols[i];
+        fsm_threaded_update(&threaded);
+    }
+    const uint64_t threaded_ns = now_ns() - start;
+    branches_stop(&branches);
+    report("fsm_threaded_update", threaded_ns, events_num, &branches);
+
+    if(reference_run.trace!=threaded_run.trace) {
+        printf("timed traces differ\n");
+        return 1;
+    }
+
+    // run to completion, a transition per symbol
+    static fsm_t consuming_reference, consuming_compiled;
+    static fsm_threaded_t consuming;
+
+    saved_seed = seed;
+    build_consuming(&consuming_reference);
+    seed = saved_seed;
+    build_consuming(&consuming_compiled);
+
+    consuming_reference.context = &reference_run;
+    consuming_compiled.context = &threaded_run;
+
+    fsm_threaded_compile(&consuming, &consuming_compiled);
+
+    reference_run = (struct run){.fsm = &consuming_reference, .symbol = symbols[0], .cursor = symbols};
+    fsm_start(&consuming_reference, 0);
+    size_t reference_taken = 0;
+
+    branches_start(&branches);
+    start = now_ns();
+    while(fsm_update(&consuming_reference)) {
+        reference_taken++;
+    }
+    const uint64_t reference_run_ns = now_ns() - start;
+    branches_stop(&branches);
+    report("fsm_update to completion", reference_run_ns, events_num, &branches);
+
+    threaded_run = (struct run){.fsm = &consuming_compiled, .symbol = symbols[0], .cursor = symbols};
+    fsm_start(&consuming_compiled, 0);
+    size_t threaded_taken = 0;
+    uint16_t taken;
+
+    branches_start(&branches);
+    start = now_ns();
+    do {
+        taken = fsm_threaded_run(&consuming, UINT16_MAX);
+        threaded_taken +=taken;
+    } while(taken==UINT16_MAX);
+    const uint64_t threaded_run_ns = now_ns() - start;
+    branches_stop(&branches);
+    report("fsm_threaded_run", threaded_run_ns, events_num, &branches);
+
+    if(reference_taken!=events_num || threaded_taken!=events_num || reference_run.trace!=threaded_run.trace
+        || consuming_reference.current->id!=consuming_compiled.current->id) {
+        printf("run to completion differs: %zu and %zu of %zu transitions\n", reference_taken, threaded_taken,
+            events_num);
+        return 1;
+    }
+
+    printf("single step x%.2f, run to completion x%.2f for the threaded interpreter\n",
+        (double)reference_ns/threaded_ns, (double)reference_run_ns/threaded_run_ns);
+
+    free(symbols);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fsm/fsm.h"
+#include "fsm/wait.h"
+
+// IDLE -> READY -> DONE, each step taken when it is asked for; the enter and exit
+// callbacks are slow and leave a mark when they are done, so a waiter that returns too early
+// finds no mark; blocked waiters must use next to no CPU and timeouts must be kept
+
+enum {
+    IDLE,
+    READY,
+    DONE
+};
+
+// a waiter may burn this much CPU while it is blocked for STEP_DELAY_MS
+#define STEP_DELAY_MS       200
+#define CALLBACK_DELAY_MS   50
+#define CPU_LIMIT_MS        20
+#define TIMEOUT_MS          100
+#define TIMEOUT_SLACK_MS    200
+
+typedef struct {
+    atomic_bool step;
+    atomic_bool ready_entered;
+    atomic_bool idle_exited;
+} example_data_t;
+
+typedef struct {
+    fsm_atomic_t *atomic;
+    example_data_t *data;
+    bool changed;
+    bool marked;
+    bool reached;
+    double cpu_ms;
+    double wall_ms;
+} waiter_t;
+
+static void sleep_ms(long ms) {
+    struct timespec ts = {ms/1000, (ms%1000)*1000000L};
+
+    nanosleep(&ts, NULL);
+}
+
+static double clock_ms(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return ts.tv_sec*1e3 + ts.tv_nsec/1e6;
+}
+
+static bool step_requested(const void *context) {
+    return atomic_load(&((const example_data_t *)context)->step);
+}
+
+static void exit_idle(void *context) {
+    sleep_ms(CALLBACK_DELAY_MS);
+    atomic_store(&((example_data_t *)context)->idle_exited, true);
+}
+
+static void enter_ready(void *context) {
+    sleep_ms(CALLBACK_DELAY_MS);
+    atomic_store(&((example_data_t *)context)->ready_entered, true);
+}
+
+static void * wait_change(void *arg) {
+    waiter_t *waiter = arg;
+    const double cpu = clock_ms(CLOCK_THREAD_CPUTIME_ID);
+
+    waiter->changed = fsm_wait_change(waiter->atomic, IDLE, FSM_WAIT_INFINITE);
+    waiter->marked = atomic_load(&waiter->data->idle_exited) && atomic_load(&waiter->data->ready_entered);
+    waiter->cpu_ms = clock_ms(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+    return NULL;
+}
+
+static void * wait_ready(void *arg) {
+    waiter_t *waiter = arg;
+    const double cpu = clock_ms(CLOCK_THREAD_CPUTIME_ID);
+
+    waiter->reached = fsm_wait_state(waiter->atomic, READY, FSM_WAIT_INFINITE);
+    waiter->marked = atomic_load(&waiter->data->ready_entered);
+    waiter->cpu_ms = clock_ms(CLOCK_THREAD_CPUTIME_ID) - cpu;
+
+    return NULL;
+}
+
+static void step(fsm_atomic_t *atomic, example_data_t *data) {
+    atomic_store(&data->step, true);
+    fsm_atomic_update(atomic);
+    atomic_store(&data->step, false);
+}
+
+static void * delayed_step(void *arg) {
+    waiter_t *stepper = arg;
+
+    sleep_ms(STEP_DELAY_MS);
+    step(stepper->atomic, stepper->data);
+
+    return NULL;
+}
+
+static bool check_blocked(const char *name, const waiter_t *waiter, bool result) {
+    printf("%-12s %s, %s, %.2f ms CPU while blocked\n", name, result ? "returned" : "timed out",
+        waiter->marked ? "after the callbacks" : "BEFORE the callbacks", waiter->cpu_ms);
+
+    return result && waiter->marked && waiter->cpu_ms<CPU_LIMIT_MS;
+}
+
+static bool check_timeout(const char *name, bool result, double wall_ms) {
+    printf("%-12s %s after %.1f ms of %d\n", name, result ? "returned" : "timed out", wall_ms, TIMEOUT_MS);
+
+    return !result && wall_ms>=TIMEOUT_MS && wall_ms<TIMEOUT_MS + TIMEOUT_SLACK_MS;
+}
+
+int main() {
+    fsm_t fsm = {0};
+    fsm_atomic_t atomic;
+    example_data_t data;
+
+    atomic_init(&data.step, false);
+    atomic_init(&data.ready_entered, false);
+    atomic_init(&data.idle_exited, false);
+
+    fsm.context = &data;
+
+    fsm_add_state(&fsm, IDLE, NULL, NULL, exit_idle);
+    fsm_add_state(&fsm, READY, enter_ready, NULL, NULL);
+    fsm_add_state(&fsm, DONE, NULL, NULL, NULL);
+    fsm_add_transition(&fsm, IDLE, READY, step_requested, NULL);
+    fsm_add_transition(&fsm, READY, DONE, step_requested, NULL);
+    fsm_start(&fsm, IDLE);
+    fsm_atomic_init(&atomic, &fsm);
+
+#ifdef FSM_WAIT_FUTEX
+    printf("futex waits\n");
+#else
+    printf("condition variable waits\n");
+#endif
+
+    bool ok = true;
+
+    // nothing steps the machine, both waits have to run out
+    double start = clock_ms(CLOCK_MONOTONIC);
+    bool result = fsm_wait_state(&atomic, DONE, TIMEOUT_MS);
+    ok = check_timeout("wait_state", result, clock_ms(CLOCK_MONOTONIC) - start) && ok;
+
+    start = clock_ms(CLOCK_MONOTONIC);
+    result = fsm_wait_change(&atomic, IDLE, TIMEOUT_MS);
+    ok = check_timeout("wait_change", result, clock_ms(CLOCK_MONOTONIC) - start) && ok;
+
+    // already there, no blocking
+    ok = fsm_wait_state(&atomic, IDLE, 0) && fsm_wait_change(&atomic, READY, 0) && ok;
+
+    // two block until IDLE -> READY and its slow callbacks are done, one more only starts
+    // waiting while those callbacks run
+    waiter_t change = {.atomic = &atomic, .data = &data}, ready = {.atomic = &atomic, .data = &data};
+    waiter_t late = {.atomic = &atomic, .data = &data}, stepper = {.atomic = &atomic, .data = &data};
+    pthread_t threads[3];
+
+    pthread_create(&threads[0], NULL, wait_change, &change);
+    pthread_create(&threads[1], NULL, wait_ready, &ready);
+    pthread_create(&threads[2], NULL, delayed_step, &stepper);
+
+    sleep_ms(STEP_DELAY_MS + CALLBACK_DELAY_MS/2);
+    wait_ready(&late);
+
+    for(int i=0; i<3; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ok = check_blocked("wait_change", &change, change.changed) && ok;
+    ok = check_blocked("wait_state", &ready, ready.reached) && ok;
+    ok = check_blocked("mid-commit", &late, late.reached) && ok;
+
+    // READY -> DONE with a finite timeout long enough to make it
+    step(&atomic, &data);
+    ok = fsm_wait_state(&atomic, DONE, TIMEOUT_MS) && fsm_atomic_state(&atomic)==DONE && ok;
+
+    printf(ok ? "waits behave\n" : "waits misbehave\n");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#ifndef FSM_ACTOR_H
+#define FSM_ACTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+#include "fsm/message.h"
+#include "fsm/runtime.h"
+
+// NULL copies the message to the start of the context, then runs fsm_update() and fsm_execute()
+typedef void (*fsm_deliver_t)(struct fsm_actor *actor, const struct fsm_message *message);
+
+struct fsm_actor_cell {
+    _Atomic uint32_t sequence;
+    struct fsm_message message;
+};
+
+// fsm comes first so runtime steps get the actor from the fsm_t pointer; the mailbox is a
+// bounded multi-producer ring, only the actor's own step reads it
+typedef struct fsm_actor {
+    fsm_t fsm;
+    fsm_deliver_t deliver;
+
+    fsm_runtime_t *runtime;
+    uint32_t id;
+
+    _Alignas(FSM_CACHE_LINE_SIZE) _Atomic uint32_t tail;
+    _Alignas(FSM_CACHE_LINE_SIZE) uint32_t head;
+    struct fsm_actor_cell cells[FSM_ACTOR_MAILBOX_SIZE];
+} fsm_actor_t;
+
+// the runtime has to be created with fsm_actor_step as its step
+void fsm_actor_step(fsm_t *fsm, void *arg);
+void fsm_actor_spawn(fsm_actor_t *actor, fsm_runtime_t *runtime, uint8_t initial);
+
+bool fsm_send(fsm_actor_t *target, uint16_t event, void *payload);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef FSM_ATOMIC_H
+#define FSM_ATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+// low half is the state index and the committing bit, high half counts commits so a stale read
+// never commits after the machine left and re-entered the same state (unless exactly 65536
+// commits came between)
+#define FSM_ATOMIC_COMMITTING       0x8000
+#define FSM_ATOMIC_INDEX(current)   ((uint16_t)((current) & 0x7fff))
+
+// concurrent mode, any thread may update: triggers run on a snapshot of the current state and
+// a transition commits with a compare-and-swap that also sets the committing bit; the winner
+// runs exit, action and enter and then clears it, a racer that loses or finds the bit set
+// returns false and runs no callback, so callbacks of consecutive transitions never overlap
+typedef struct {
+    fsm_t *fsm;
+    _Atomic uint32_t current;
+
+    // threads blocked in fsm_wait_*(), commits skip the wake-up while there are none
+    _Atomic uint32_t waiters;
+} fsm_atomic_t;
+
+// the machine has to be started, afterwards it must only be driven through fsm_atomic_*()
+void fsm_atomic_init(fsm_atomic_t *atomic, fsm_t *fsm);
+bool fsm_atomic_update(fsm_atomic_t *atomic);
+void fsm_atomic_execute(fsm_atomic_t *atomic);
+uint8_t fsm_atomic_state(fsm_atomic_t *atomic);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FSM_BUILDER_H
+#define FSM_BUILDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/fsm.h"
+
+// bump allocator over a caller's buffer, nothing is freed on its own
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+} fsm_arena_t;
+
+struct fsm_builder_state {
+    uint8_t id;
+    fsm_callback_t enter;
+    fsm_callback_t execute;
+    fsm_callback_t exit;
+    uint16_t events_num;
+};
+
+// from and to are positions in states[]
+struct fsm_builder_transition {
+    uint16_t from;
+    uint16_t to;
+    fsm_trigger_t trigger;
+    fsm_callback_t action;
+};
+
+// records a machine of any size without FSM_STATE_MAX_NUM / FSM_EVENT_MAX_NUM, then writes it
+// as a frozen machine of exactly the size it needs; states keep the order they were added in
+typedef struct {
+    // heap allocated, grown on demand
+    struct fsm_builder_state *states;
+    uint16_t states_num;
+    uint32_t states_cap;
+    struct fsm_builder_transition *transitions;
+    uint32_t transitions_num;
+    uint32_t transitions_cap;
+
+    // set by a failed add call, cleared by fsm_builder_free()
+    bool failed;
+} fsm_builder_t;
+
+void fsm_arena_init(fsm_arena_t *arena, void *buffer, size_t size);
+void * fsm_arena_alloc(fsm_arena_t *arena, size_t size, size_t alignment);
+void fsm_arena_reset(fsm_arena_t *arena);
+
+bool fsm_builder_add_state(fsm_builder_t *builder, uint8_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit);
+bool fsm_builder_add_transition(fsm_builder_t *builder, uint8_t from, uint8_t to, fsm_trigger_t trigger, fsm_callback_t action);
+
+size_t fsm_builder_size(const fsm_builder_t *builder);
+const struct fsm_frozen * fsm_builder_build(const fsm_builder_t *builder, fsm_arena_t *arena);
+void fsm_builder_free(fsm_builder_t *builder);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef FSM_COMBINE_H
+#define FSM_COMBINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+#include "fsm/message.h"
+
+// NULL copies the message to the start of the context, then runs fsm_update() and fsm_execute()
+typedef void (*fsm_combine_deliver_t)(fsm_t *fsm, const struct fsm_message *message);
+
+// one per dispatching thread, written by its owner and cleared by the combiner
+struct fsm_combine_slot {
+    _Alignas(FSM_CACHE_LINE_SIZE) _Atomic uint32_t pending;
+    struct fsm_message message;
+};
+
+// flat combining: threads publish an event in their slot, whoever takes the lock delivers the
+// events of every slot, pass after pass while any is pending, and the others wait for their
+// slot to clear
+typedef struct {
+    fsm_t *fsm;
+    fsm_combine_deliver_t deliver;
+
+    _Alignas(FSM_CACHE_LINE_SIZE) atomic_bool locked;
+    _Atomic uint32_t slots_num;
+    struct fsm_combine_slot slots[FSM_COMBINE_SLOT_NUM];
+
+    // updated by the combiner only, passes that delivered at least one event
+    uint64_t passes;
+    uint64_t delivered;
+} fsm_combine_t;
+
+void fsm_combine_init(fsm_combine_t *combine, fsm_t *fsm, fsm_combine_deliver_t deliver);
+uint16_t fsm_combine_register(fsm_combine_t *combine);
+void fsm_combine_dispatch(fsm_combine_t *combine, uint16_t slot, uint16_t event, void *payload);
+
+#endif
@@ -9,4 +9,125 @@
     #define FSM_EVENT_MAX_NUM   5
 #endif
 
+// cells per compiled machine, worst case is 13 cells per transition and 1 per state
+#ifndef FSM_THREADED_PROGRAM_SIZE
+    #define FSM_THREADED_PROGRAM_SIZE   (FSM_STATE_MAX_NUM*(1 + 13*FSM_EVENT_MAX_NUM))
+#endif
+
+#ifndef FSM_STREAM_STATE_MAX_NUM
+    #define FSM_STREAM_STATE_MAX_NUM        16
+#endif
+
+#ifndef FSM_STREAM_TRANSITION_MAX_NUM
+    #define FSM_STREAM_TRANSITION_MAX_NUM   64
+#endif
+
+#ifndef FSM_STREAM_ACTION_MAX_NUM
+    #define FSM_STREAM_ACTION_MAX_NUM       8
+#endif
+
+// columns per row, 256 indexes rows by byte directly, fewer adds a byte class lookup per byte
+#ifndef FSM_STREAM_CLASS_MAX_NUM
+    #define FSM_STREAM_CLASS_MAX_NUM        256
+#endif
+
+#ifndef FSM_PARALLEL_THREAD_MAX_NUM
+    #define FSM_PARALLEL_THREAD_MAX_NUM     64
+#endif
+
+// smaller inputs are fed serially
+#ifndef FSM_PARALLEL_CHUNK_MIN_LEN
+    #define FSM_PARALLEL_CHUNK_MIN_LEN      65536
+#endif
+
+// longer inputs are fed in pieces of this many bytes per thread
+#ifndef FSM_PARALLEL_CHUNK_MAX_LEN
+    #define FSM_PARALLEL_CHUNK_MAX_LEN      (1<<22)
+#endif
+
+// actions a chunk records before the rest of it is left to be fed serially
+#ifndef FSM_PARALLEL_LOG_MAX_NUM
+    #define FSM_PARALLEL_LOG_MAX_NUM        (1<<20)
+#endif
+
+#ifndef FSM_NFA_STATE_MAX_NUM
+    #define FSM_NFA_STATE_MAX_NUM           64
+#endif
+
+#ifndef FSM_NFA_EVENT_MAX_NUM
+    #define FSM_NFA_EVENT_MAX_NUM           16
+#endif
+
+// memory budget of the lazy DFA, in cached DFA states
+#ifndef FSM_DFA_CACHE_NUM
+    #define FSM_DFA_CACHE_NUM               64
+#endif
+
+// a flush sooner than this many events after the previous one switches to NFA stepping
+#ifndef FSM_DFA_THRASH_STEPS
+    #define FSM_DFA_THRASH_STEPS            (4*FSM_DFA_CACHE_NUM)
+#endif
+
+#ifndef FSM_DFA_FALLBACK_STEPS
+    #define FSM_DFA_FALLBACK_STEPS          1024
+#endif
+
+// fsm_table_build() keeps the dense [state][event] table down to this fill ratio
+#ifndef FSM_TABLE_DENSE_MIN_PERCENT
+    #define FSM_TABLE_DENSE_MIN_PERCENT     25
+#endif
+
+// and at any fill ratio while its cells take no more than this, the other layouts are slower
+#ifndef FSM_TABLE_DENSE_MAX_BYTES
+    #define FSM_TABLE_DENSE_MAX_BYTES       (1<<20)
+#endif
+
+// when a comb packs badly, rows up to this length are binary searched, longer ones hashed
+#ifndef FSM_TABLE_SPARSE_MAX_ROW
+    #define FSM_TABLE_SPARSE_MAX_ROW        8
+#endif
+
+// alignment of data written by different threads
+#ifndef FSM_CACHE_LINE_SIZE
+    #define FSM_CACHE_LINE_SIZE             64
+#endif
+
+// per-worker deque slots, a power of two, overflow goes to the shared queue
+#ifndef FSM_RUNTIME_DEQUE_SIZE
+    #define FSM_RUNTIME_DEQUE_SIZE          4096
+#endif
+
+// instances a worker moves from the shared queue to its deque at once
+#ifndef FSM_RUNTIME_INJECT_BATCH
+    #define FSM_RUNTIME_INJECT_BATCH        32
+#endif
+
+// messages an actor holds, a power of two, fsm_send() fails when it is full
+#ifndef FSM_ACTOR_MAILBOX_SIZE
+    #define FSM_ACTOR_MAILBOX_SIZE          64
+#endif
+
+// messages delivered per step, the rest wait for the next one
+#ifndef FSM_ACTOR_BATCH
+    #define FSM_ACTOR_BATCH                 16
+#endif
+
+// threads that may dispatch to one combining front end
+#ifndef FSM_COMBINE_SLOT_NUM
+    #define FSM_COMBINE_SLOT_NUM            64
+#endif
+
+// passes a combiner makes while events keep arriving, bounds how long it works for others
+#ifndef FSM_COMBINE_PASS_MAX_NUM
+    #define FSM_COMBINE_PASS_MAX_NUM        8
+#endif
+
+#ifndef FSM_LOOP_SOURCE_MAX_NUM
+    #define FSM_LOOP_SOURCE_MAX_NUM 4
+#endif
+
+#ifndef FSM_LOOP_TIMER_MAX_NUM
+    #define FSM_LOOP_TIMER_MAX_NUM  4
+#endif
+
 #endif
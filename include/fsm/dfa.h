@@ -0,0 +1,45 @@
+#ifndef FSM_DFA_H
+#define FSM_DFA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+#include "fsm/nfa.h"
+
+#define FSM_DFA_NONE    UINT16_MAX
+
+// one subset of NFA states, next[] is filled on first use of every event
+struct fsm_dfa_state {
+    fsm_nfa_set_t set;
+    uint16_t next[FSM_NFA_EVENT_MAX_NUM];
+    bool accepting;
+};
+
+typedef struct {
+    const fsm_nfa_t *nfa;
+
+    struct fsm_dfa_state states[FSM_DFA_CACHE_NUM];
+    uint16_t states_num;
+    uint16_t table[2*FSM_DFA_CACHE_NUM];
+
+    // FSM_DFA_NONE while stepping the NFA set directly
+    uint16_t current;
+    fsm_nfa_set_t set;
+    uint64_t since_flush;
+    uint32_t fallback;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t flushes;
+    uint64_t fallback_steps;
+} fsm_dfa_t;
+
+void fsm_dfa_start(fsm_dfa_t *dfa, const fsm_nfa_t *nfa, uint16_t initial);
+void fsm_dfa_dispatch(fsm_dfa_t *dfa, uint8_t event);
+void fsm_dfa_feed(fsm_dfa_t *dfa, const uint8_t *events, size_t len);
+
+bool fsm_dfa_accepts(const fsm_dfa_t *dfa);
+
+#endif
@@ -2,6 +2,7 @@
 #define FSM_FSM_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "fsm/config.h"
@@ -9,6 +10,12 @@
 typedef void (*fsm_callback_t)(void *);
 typedef bool (*fsm_trigger_t)(const void *);
 
+#if FSM_STATE_MAX_NUM>256
+typedef uint16_t fsm_index_t;
+#else
+typedef uint8_t fsm_index_t;
+#endif
+
 struct fsm_state;
 
 struct fsm_event {
@@ -27,19 +34,70 @@ struct fsm_state {
 	uint8_t events_num;
 };
 
+// hot part of a frozen state, its events are triggers[first..first+events_num)
+struct fsm_frozen_state {
+    uint16_t first;
+    uint8_t events_num;
+};
+
+// rarely touched part of a frozen state, only on transitions and start
+struct fsm_frozen_cold {
+    fsm_callback_t enter;
+    fsm_callback_t exit;
+    uint8_t id;
+};
+
+// read-only, index-based form of a machine, all arrays live in one block
+struct fsm_frozen {
+    uint16_t states_num;
+    uint16_t events_num;
+
+    const struct fsm_frozen_state *states;
+    const fsm_trigger_t *triggers;
+    const fsm_index_t *next;
+    const fsm_callback_t *execute;
+
+    const fsm_callback_t *actions;
+    const struct fsm_frozen_cold *cold;
+};
+
 typedef struct {
     void *context;
 
 	struct fsm_state *current;
 	struct fsm_state states[FSM_STATE_MAX_NUM];
 	uint8_t states_num;
+
+    const struct fsm_frozen *frozen;
+    fsm_index_t index;
 } fsm_t;
 
+// running copy of a frozen machine, the definition is shared read-only by any number of instances
+// and only index changes; every instance owns whole cache lines so arrays of instances updated
+// from different threads do not false-share
+typedef struct {
+    _Alignas(FSM_CACHE_LINE_SIZE) const struct fsm_frozen *frozen;
+    void *context;
+    fsm_index_t index;
+} fsm_instance_t;
+
 void fsm_add_state(fsm_t *fsm, uint8_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit);
 void fsm_add_transition(fsm_t *fsm, uint8_t from, uint8_t to, fsm_trigger_t trigger, fsm_callback_t action);
 
+size_t fsm_freeze(fsm_t *fsm, void *buffer, size_t size);
+size_t fsm_frozen_size(uint16_t states_num, uint16_t events_num);
+struct fsm_frozen * fsm_frozen_layout(void *buffer, uint16_t states_num, uint16_t events_num);
+
 void fsm_start(fsm_t *fsm, uint8_t initial);
-void fsm_update(fsm_t *fsm);
+bool fsm_update(fsm_t *fsm);
 void fsm_execute(fsm_t *fsm);
 
+fsm_index_t fsm_frozen_start(const struct fsm_frozen *frozen, void *context, uint8_t initial);
+bool fsm_frozen_update(const struct fsm_frozen *frozen, fsm_index_t *index, void *context);
+void fsm_frozen_execute(const struct fsm_frozen *frozen, fsm_index_t index, void *context);
+
+void fsm_instance_start(fsm_instance_t *instance, const struct fsm_frozen *frozen, void *context, uint8_t initial);
+bool fsm_instance_update(fsm_instance_t *instance);
+void fsm_instance_execute(fsm_instance_t *instance);
+
 #endif
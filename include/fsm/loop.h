@@ -0,0 +1,42 @@
+#ifndef FSM_LOOP_H
+#define FSM_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+// reads pending input into context, returns true if the machine should be updated
+typedef bool (*fsm_loop_read_t)(void *, int);
+
+struct fsm_loop_source {
+    int fd;
+    fsm_loop_read_t read;
+};
+
+struct fsm_loop_timer {
+    uint32_t period;
+    uint64_t deadline;
+    fsm_callback_t callback;
+};
+
+typedef struct {
+    fsm_t *fsm;
+
+    struct fsm_loop_source sources[FSM_LOOP_SOURCE_MAX_NUM];
+    uint8_t sources_num;
+
+    struct fsm_loop_timer timers[FSM_LOOP_TIMER_MAX_NUM];
+    uint8_t timers_num;
+
+    bool running;
+} fsm_loop_t;
+
+void fsm_loop_add_source(fsm_loop_t *loop, int fd, fsm_loop_read_t read);
+void fsm_loop_add_timer(fsm_loop_t *loop, uint32_t period_ms, fsm_callback_t callback);
+
+int fsm_loop_run(fsm_loop_t *loop);
+void fsm_loop_stop(fsm_loop_t *loop);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef FSM_MESSAGE_H
+#define FSM_MESSAGE_H
+
+#include <stdint.h>
+
+struct fsm_actor;
+
+// event handed to a machine from another thread, by default copied to the start of the
+// context where triggers read it; the payload is handed over, not copied
+struct fsm_message {
+    uint16_t event;
+    void *payload;
+    struct fsm_actor *sender;
+};
+
+#endif
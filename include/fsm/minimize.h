@@ -0,0 +1,22 @@
+#ifndef FSM_MINIMIZE_H
+#define FSM_MINIMIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/table.h"
+
+struct fsm_minimize_report {
+    uint16_t states_before;
+    uint16_t states_after;
+    size_t bytes_before;
+    size_t bytes_after;
+};
+
+// merges equivalent states and drops the ones unreachable from initial, call before fsm_table_build();
+// states are equivalent when their callbacks match and every event leads with the same action to
+// equivalent states, map (optional, states_num entries) gets old id -> new id or FSM_TABLE_NONE,
+// returns the new id of initial
+uint16_t fsm_minimize(fsm_table_t *table, uint16_t initial, uint16_t *map, struct fsm_minimize_report *report);
+
+#endif
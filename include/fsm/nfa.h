@@ -0,0 +1,40 @@
+#ifndef FSM_NFA_H
+#define FSM_NFA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+
+#define FSM_NFA_WORDS   ((FSM_NFA_STATE_MAX_NUM + 63)/64)
+
+typedef struct {
+    uint64_t bits[FSM_NFA_WORDS];
+} fsm_nfa_set_t;
+
+// delta rows are epsilon-closed by fsm_nfa_compile(), a step is an OR of the rows of active states
+typedef struct {
+    fsm_nfa_set_t active;
+    fsm_nfa_set_t accepting;
+
+    fsm_nfa_set_t closure[FSM_NFA_STATE_MAX_NUM];
+    fsm_nfa_set_t delta[FSM_NFA_EVENT_MAX_NUM][FSM_NFA_STATE_MAX_NUM];
+
+    uint16_t states_num;
+    uint8_t events_num;
+    bool compiled;
+} fsm_nfa_t;
+
+void fsm_nfa_add_transition(fsm_nfa_t *nfa, uint16_t from, uint16_t to, uint8_t event);
+void fsm_nfa_add_epsilon(fsm_nfa_t *nfa, uint16_t from, uint16_t to);
+void fsm_nfa_set_accepting(fsm_nfa_t *nfa, uint16_t state);
+void fsm_nfa_compile(fsm_nfa_t *nfa);
+
+void fsm_nfa_start(fsm_nfa_t *nfa, uint16_t initial);
+void fsm_nfa_dispatch(fsm_nfa_t *nfa, uint8_t event);
+void fsm_nfa_step(const fsm_nfa_t *nfa, const fsm_nfa_set_t *from, uint8_t event, fsm_nfa_set_t *to);
+
+bool fsm_nfa_is_active(const fsm_nfa_t *nfa, uint16_t state);
+bool fsm_nfa_accepts(const fsm_nfa_t *nfa);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef FSM_PARALLEL_H
+#define FSM_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+#include "fsm/stream.h"
+
+// same final state and action sequence as fsm_feed(), actions are called from the calling thread;
+// a chunk whose thread cannot be created, or whose action log is full or cannot grow, is fed
+// serially from where it stopped
+void fsm_feed_parallel(fsm_stream_t *stream, const uint8_t *buf, size_t len, unsigned int threads);
+
+#endif
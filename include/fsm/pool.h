@@ -0,0 +1,73 @@
+#ifndef FSM_POOL_H
+#define FSM_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fsm/fsm.h"
+#include "fsm/message.h"
+
+// generation in the high half, slot in the low half, a destroyed instance's handle never
+// becomes valid again until the generation wraps
+typedef uint64_t fsm_handle_t;
+
+#define FSM_POOL_NONE   ((fsm_handle_t)0)
+
+// live instances are entries[0..instances_num), in no particular order
+struct fsm_pool_entry {
+    void *context;
+    uint32_t slot;
+    fsm_index_t index;
+};
+
+typedef void (*fsm_pool_visit_t)(fsm_handle_t handle, void *context, uint8_t state, void *arg);
+
+// slot map of instances that all run one frozen machine, storage is allocated once by
+// fsm_pool_init(), create and destroy are O(1) and destroy moves the last entry into the hole
+typedef struct {
+    const struct fsm_frozen *frozen;
+
+    struct fsm_pool_entry *entries;
+    uint32_t instances_num;
+    uint32_t instances_cap;
+
+    // per slot: position in entries while live, next free slot while free
+    uint32_t *positions;
+    uint32_t *generations;
+    uint32_t free_head;
+
+    // per state a bitmap of the positions in entries that are in it, words_num words each,
+    // updated on every transition made through the pool
+    uint64_t *members;
+    uint32_t words_num;
+    uint32_t *counts;
+    fsm_index_t lookup[256];
+} fsm_pool_t;
+
+void fsm_pool_init(fsm_pool_t *pool, const struct fsm_frozen *frozen, uint32_t instances_cap);
+void fsm_pool_free(fsm_pool_t *pool);
+
+fsm_handle_t fsm_pool_create(fsm_pool_t *pool, void *context, uint8_t initial);
+bool fsm_pool_destroy(fsm_pool_t *pool, fsm_handle_t handle);
+bool fsm_pool_valid(const fsm_pool_t *pool, fsm_handle_t handle);
+
+// every call taking a handle checks it, a stale or made-up one is rejected and touches nothing
+bool fsm_pool_update(fsm_pool_t *pool, fsm_handle_t handle);
+bool fsm_pool_execute(fsm_pool_t *pool, fsm_handle_t handle);
+bool fsm_pool_state(const fsm_pool_t *pool, fsm_handle_t handle, uint8_t *state);
+
+// iteration over live instances, none may be created or destroyed meanwhile
+fsm_handle_t fsm_pool_handle(const fsm_pool_t *pool, uint32_t position);
+uint32_t fsm_pool_update_all(fsm_pool_t *pool);
+void fsm_pool_execute_all(fsm_pool_t *pool);
+void fsm_pool_each(const fsm_pool_t *pool, fsm_pool_visit_t visit, void *arg);
+
+// queries by state walk its bitmap in position order, a word per 64 instances of capacity plus
+// the instances in that state; an id the machine does not have counts as an empty state
+uint32_t fsm_pool_count(const fsm_pool_t *pool, uint8_t state);
+fsm_handle_t fsm_pool_first(const fsm_pool_t *pool, uint8_t state);
+fsm_handle_t fsm_pool_next(const fsm_pool_t *pool, fsm_handle_t handle);
+void fsm_pool_each_in(const fsm_pool_t *pool, uint8_t state, fsm_pool_visit_t visit, void *arg);
+uint32_t fsm_pool_broadcast(fsm_pool_t *pool, uint8_t state, uint16_t event, void *payload);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FSM_RUNTIME_H
+#define FSM_RUNTIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+#define FSM_RUNTIME_NONE    UINT32_MAX
+
+// runs once per notification burst, NULL runs fsm_update() and fsm_execute()
+typedef void (*fsm_step_t)(fsm_t *fsm, void *arg);
+
+// Chase-Lev deque, the owner pushes and takes at bottom, thieves take at top
+struct fsm_runtime_deque {
+    _Alignas(FSM_CACHE_LINE_SIZE) atomic_int_fast64_t top;
+    _Alignas(FSM_CACHE_LINE_SIZE) atomic_int_fast64_t bottom;
+    _Alignas(FSM_CACHE_LINE_SIZE) _Atomic uint32_t buffer[FSM_RUNTIME_DEQUE_SIZE];
+};
+
+struct fsm_runtime_worker {
+    struct fsm_runtime_deque deque;
+
+    struct fsm_runtime *runtime;
+    pthread_t thread;
+    uint32_t seed;
+
+    uint64_t steps;
+    uint64_t steals;
+};
+
+// an instance is in at most one queue: idle -> scheduled -> running -> idle, a notification
+// while running sends it back to the queue once the step is over
+typedef struct fsm_runtime {
+    fsm_t **instances;
+    _Atomic uint8_t *status;
+    uint32_t instances_num;
+    uint32_t instances_cap;
+
+    fsm_step_t step;
+    void *arg;
+
+    struct fsm_runtime_worker *workers;
+    unsigned int workers_num;
+
+    // shared queue for notifications from outside the workers and deque overflow
+    pthread_mutex_t injector_lock;
+    uint32_t *injector;
+    uint32_t injector_head;
+    uint32_t injector_cap;
+    atomic_uint_fast32_t injector_num;
+
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    atomic_uint sleepers;
+    uint32_t epoch;
+
+    // scheduled or running instances
+    atomic_uint_fast64_t pending;
+    atomic_bool running;
+} fsm_runtime_t;
+
+bool fsm_runtime_init(fsm_runtime_t *runtime, uint32_t instances_cap, fsm_step_t step, void *arg);
+uint32_t fsm_runtime_add(fsm_runtime_t *runtime, fsm_t *fsm);
+
+bool fsm_runtime_start(fsm_runtime_t *runtime, unsigned int threads);
+void fsm_runtime_notify(fsm_runtime_t *runtime, uint32_t id);
+void fsm_runtime_wait_idle(fsm_runtime_t *runtime);
+void fsm_runtime_stop(fsm_runtime_t *runtime);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef FSM_SEQLOCK_H
+#define FSM_SEQLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+struct fsm_snapshot {
+    uint8_t state;
+    uint64_t entered_ns;
+    uint64_t transitions;
+};
+
+// one writer drives the machine through fsm_seqlock_update() and publishes every transition,
+// readers on other threads retry until they got a snapshot no publish overlapped, they never
+// block the writer; entered_ns is CLOCK_MONOTONIC
+//
+// overhead: an update that takes no transition costs what fsm_update() does, one that takes a
+// transition adds a clock_gettime() call, usually a vDSO read of a few tens of ns and the bulk
+// of the cost, and five stores to a line readers keep pulling away, which costs a cache miss
+// per publish while a reader on another core is polling
+typedef struct {
+    fsm_t *fsm;
+
+    _Alignas(FSM_CACHE_LINE_SIZE) _Atomic uint32_t sequence;
+    _Atomic uint32_t state;
+    _Atomic uint64_t entered_ns;
+    _Atomic uint64_t transitions;
+} fsm_seqlock_t;
+
+// the machine has to be started, its start counts as entering the initial state
+void fsm_seqlock_init(fsm_seqlock_t *seqlock, fsm_t *fsm);
+bool fsm_seqlock_update(fsm_seqlock_t *seqlock);
+void fsm_seqlock_read(const fsm_seqlock_t *seqlock, struct fsm_snapshot *snapshot);
+
+#endif
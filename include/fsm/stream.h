@@ -0,0 +1,61 @@
+#ifndef FSM_STREAM_H
+#define FSM_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+
+// rows are indexed by byte unless fewer columns than bytes are configured, then by byte class
+#if FSM_STREAM_CLASS_MAX_NUM<256
+    #define FSM_STREAM_BYTE_CLASSES
+    #define FSM_STREAM_COLUMN(stream, byte)     ((stream)->classes[byte])
+#else
+    #define FSM_STREAM_COLUMN(stream, byte)     (byte)
+#endif
+
+// called on marked transitions with the position of the byte that caused it
+typedef void (*fsm_stream_action_t)(void *, const uint8_t *);
+
+struct fsm_stream_transition {
+    uint8_t from;
+    uint8_t to;
+    uint8_t first;
+    uint8_t last;
+    uint8_t action;
+};
+
+// next is the offset of the next state's row, action 0 means none
+struct fsm_stream_cell {
+    uint16_t next;
+    uint8_t action;
+};
+
+typedef struct {
+    void *context;
+    uint8_t current;
+
+#ifdef FSM_STREAM_BYTE_CLASSES
+    uint8_t classes[256];
+#endif
+    uint16_t classes_num;
+    struct fsm_stream_cell cells[FSM_STREAM_STATE_MAX_NUM*FSM_STREAM_CLASS_MAX_NUM];
+
+    fsm_stream_action_t actions[FSM_STREAM_ACTION_MAX_NUM + 1];
+    uint8_t actions_num;
+
+    struct fsm_stream_transition transitions[FSM_STREAM_TRANSITION_MAX_NUM];
+    uint16_t transitions_num;
+    uint8_t states_num;
+    bool compiled;
+} fsm_stream_t;
+
+void fsm_stream_add_transition(fsm_stream_t *stream, uint8_t from, uint8_t to, uint8_t first, uint8_t last, fsm_stream_action_t action);
+// false when the byte classes do not fit FSM_STREAM_CLASS_MAX_NUM
+bool fsm_stream_compile(fsm_stream_t *stream);
+
+void fsm_stream_start(fsm_stream_t *stream, uint8_t initial);
+void fsm_feed(fsm_stream_t *stream, const uint8_t *buf, size_t len);
+
+#endif
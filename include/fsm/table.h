@@ -0,0 +1,91 @@
+#ifndef FSM_TABLE_H
+#define FSM_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+#define FSM_TABLE_NONE  UINT16_MAX
+
+// states are numbered 0..states_num-1, transitions are keyed by event id
+struct fsm_table_state {
+    fsm_callback_t enter;
+    fsm_callback_t execute;
+    fsm_callback_t exit;
+};
+
+struct fsm_table_transition {
+    uint16_t from;
+    uint16_t to;
+    uint16_t event;
+    fsm_callback_t action;
+};
+
+// next is FSM_TABLE_NONE when the event is ignored, action indexes actions[], 0 means none
+struct fsm_table_cell {
+    uint16_t next;
+    uint16_t action;
+};
+
+// key is the event in sparse rows and the owning state in comb slots
+struct fsm_table_entry {
+    uint16_t key;
+    struct fsm_table_cell cell;
+};
+
+// one per (state, event) pair, placed by a minimal perfect hash
+struct fsm_table_slot {
+    uint16_t state;
+    uint16_t event;
+    struct fsm_table_cell cell;
+};
+
+enum fsm_table_layout {
+    FSM_TABLE_AUTO,
+    FSM_TABLE_DENSE,    // cells[state*events_num + event]
+    FSM_TABLE_SPARSE,   // entries[rows[state]..rows[state + 1]], sorted by event
+    FSM_TABLE_COMB,     // entries[rows[state] + event] when its key is state (row displacement)
+    FSM_TABLE_HASH      // slots[] indexed by a hash seeded with rows[bucket], checked against its key
+};
+
+typedef struct {
+    void *context;
+    uint16_t current;
+
+    // builder, heap allocated, grown on demand
+    struct fsm_table_state *states;
+    uint16_t states_num;
+    uint32_t states_cap;
+    struct fsm_table_transition *transitions;
+    uint32_t transitions_num;
+    uint32_t transitions_cap;
+    uint16_t events_num;
+
+    // dispatch structure, created by fsm_table_build()
+    enum fsm_table_layout layout;
+    fsm_callback_t *actions;
+    uint16_t actions_num;
+    struct fsm_table_cell *cells;
+    uint32_t *rows;
+    struct fsm_table_entry *entries;
+    uint32_t entries_num;
+    struct fsm_table_slot *slots;
+    uint32_t buckets_num;
+} fsm_table_t;
+
+void fsm_table_add_state(fsm_table_t *table, uint16_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit);
+void fsm_table_add_transition(fsm_table_t *table, uint16_t from, uint16_t to, uint16_t event, fsm_callback_t action);
+// fsm_table_build() picks the layout from the dense size and the measured fill ratio
+void fsm_table_build(fsm_table_t *table);
+void fsm_table_build_layout(fsm_table_t *table, enum fsm_table_layout layout);
+size_t fsm_table_bytes(const fsm_table_t *table);
+void fsm_table_free(fsm_table_t *table);
+
+void fsm_table_start(fsm_table_t *table, uint16_t initial);
+bool fsm_table_dispatch(fsm_table_t *table, uint16_t event);
+void fsm_table_execute(fsm_table_t *table);
+
+#endif
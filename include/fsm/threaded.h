@@ -0,0 +1,38 @@
+#ifndef FSM_THREADED_H
+#define FSM_THREADED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fsm/config.h"
+#include "fsm/fsm.h"
+
+// labels-as-values dispatch on GCC/Clang, define FSM_THREADED_PORTABLE to force the switch fallback
+#if defined(__GNUC__) && !defined(FSM_THREADED_PORTABLE)
+    #define FSM_THREADED_COMPUTED_GOTO
+#endif
+
+union fsm_threaded_cell {
+    const void *label;
+    uintptr_t op;
+    fsm_trigger_t trigger;
+    fsm_callback_t callback;
+    uint16_t pc;
+};
+
+typedef struct {
+    fsm_t *fsm;
+
+    uint16_t entry[FSM_STATE_MAX_NUM];
+    union fsm_threaded_cell program[FSM_THREADED_PROGRAM_SIZE];
+    uint16_t program_size;
+} fsm_threaded_t;
+
+// the program copies the states, transitions and callbacks of fsm as they are now, it goes
+// stale once a state or transition is added, compile again after changing fsm
+void fsm_threaded_compile(fsm_threaded_t *threaded, fsm_t *fsm);
+
+uint16_t fsm_threaded_run(fsm_threaded_t *threaded, uint16_t max_steps);
+bool fsm_threaded_update(fsm_threaded_t *threaded);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef FSM_WAIT_H
+#define FSM_WAIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fsm/atomic.h"
+
+#define FSM_WAIT_INFINITE   (-1)
+
+// blocking waits on concurrent-mode machines, sleepers are woken only by committed transitions;
+// futex on Linux, define FSM_WAIT_PORTABLE to force the condition variable fallback
+#if defined(__linux__) && !defined(FSM_WAIT_PORTABLE)
+    #define FSM_WAIT_FUTEX
+#endif
+
+// both return false when timeout_ms ran out first, a state is reached or left only once the
+// callbacks of the transition have returned
+bool fsm_wait_state(fsm_atomic_t *atomic, uint8_t id, int32_t timeout_ms);
+bool fsm_wait_change(fsm_atomic_t *atomic, uint8_t old, int32_t timeout_ms);
+
+// called by fsm_atomic_update() after a commit that waiters may be blocked on
+void fsm_wait_wake(fsm_atomic_t *atomic);
+
+#endif
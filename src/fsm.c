@@ -14,7 +14,12 @@ static struct fsm_state * find_state(fsm_t *fsm, uint8_t id) {
     return NULL;
 }
 
+static size_t align_up(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
 void fsm_add_state(fsm_t *fsm, uint8_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit) {
+    assert(!fsm->frozen);
     assert(fsm->states_num<FSM_STATE_MAX_NUM);
 
     fsm->states[fsm->states_num].id = id;
@@ -26,6 +31,8 @@ void fsm_add_state(fsm_t *fsm, uint8_t id, fsm_callback_t enter, fsm_callback_t
 }
 
 void fsm_add_transition(fsm_t *fsm, uint8_t from, uint8_t to, fsm_trigger_t trigger, fsm_callback_t action) {
+    assert(!fsm->frozen);
+
     struct fsm_state *from_state = find_state(fsm, from);
 	struct fsm_state *to_state = find_state(fsm, to);
 
@@ -39,7 +46,152 @@ void fsm_add_transition(fsm_t *fsm, uint8_t from, uint8_t to, fsm_trigger_t trig
 	from_state->events_num++;
 }
 
+struct frozen_offsets {
+    size_t triggers;
+    size_t execute;
+    size_t actions;
+    size_t cold;
+    size_t states;
+    size_t next;
+    size_t size;
+};
+
+static void frozen_offsets(struct frozen_offsets *offsets, uint16_t states_num, uint16_t events_num) {
+    size_t offset = sizeof(struct fsm_frozen);
+
+    offsets->triggers = offset = align_up(offset, sizeof(fsm_trigger_t));
+    offset +=events_num*sizeof(fsm_trigger_t);
+    offsets->execute = offset = align_up(offset, sizeof(fsm_callback_t));
+    offset +=states_num*sizeof(fsm_callback_t);
+    offsets->actions = offset;
+    offset +=events_num*sizeof(fsm_callback_t);
+    offsets->cold = offset = align_up(offset, sizeof(fsm_callback_t));
+    offset +=states_num*sizeof(struct fsm_frozen_cold);
+    offsets->states = offset = align_up(offset, sizeof(uint16_t));
+    offset +=states_num*sizeof(struct fsm_frozen_state);
+    offsets->next = offset = align_up(offset, sizeof(fsm_index_t));
+    offset +=events_num*sizeof(fsm_index_t);
+    offsets->size = offset;
+}
+
+// bytes of a frozen machine with these counts, all arrays included
+size_t fsm_frozen_size(uint16_t states_num, uint16_t events_num) {
+    struct frozen_offsets offsets;
+
+    frozen_offsets(&offsets, states_num, events_num);
+
+    return offsets.size;
+}
+
+// places the header and its arrays in buffer (fsm_frozen_size() bytes, pointer aligned),
+// the arrays are left for the caller to fill
+struct fsm_frozen * fsm_frozen_layout(void *buffer, uint16_t states_num, uint16_t events_num) {
+    struct frozen_offsets offsets;
+    uint8_t *base = buffer;
+    struct fsm_frozen *frozen = buffer;
+
+    assert(((uintptr_t)buffer % sizeof(void *))==0);
+
+    frozen_offsets(&offsets, states_num, events_num);
+
+    frozen->states_num = states_num;
+    frozen->events_num = events_num;
+    frozen->states = (const struct fsm_frozen_state *)(base + offsets.states);
+    frozen->triggers = (const fsm_trigger_t *)(base + offsets.triggers);
+    frozen->next = (const fsm_index_t *)(base + offsets.next);
+    frozen->execute = (const fsm_callback_t *)(base + offsets.execute);
+    frozen->actions = (const fsm_callback_t *)(base + offsets.actions);
+    frozen->cold = (const struct fsm_frozen_cold *)(base + offsets.cold);
+
+    return frozen;
+}
+
+size_t fsm_freeze(fsm_t *fsm, void *buffer, size_t size) {
+    assert(!fsm->frozen);
+
+    uint16_t events_num = 0;
+
+    for(uint8_t i=0; i<fsm->states_num; i++) {
+        events_num +=fsm->states[i].events_num;
+    }
+
+    const size_t size_needed = fsm_frozen_size(fsm->states_num, events_num);
+
+    if(!buffer || size<size_needed) {
+        return size_needed;
+    }
+
+    // states entered most often come first, incoming transition count is the estimate
+    uint16_t incoming[FSM_STATE_MAX_NUM] = {0};
+    fsm_index_t order[FSM_STATE_MAX_NUM];
+    fsm_index_t rank[FSM_STATE_MAX_NUM];
+
+    for(uint8_t i=0; i<fsm->states_num; i++) {
+        for(uint8_t j=0; j<fsm->states[i].events_num; j++) {
+            incoming[fsm->states[i].events[j].next - fsm->states]++;
+        }
+    }
+
+    for(uint8_t i=0; i<fsm->states_num; i++) {
+        uint8_t k = i;
+
+        while(k>0 && incoming[order[k - 1]]<incoming[i]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+
+        order[k] = i;
+    }
+
+    for(uint8_t k=0; k<fsm->states_num; k++) {
+        rank[order[k]] = k;
+    }
+
+    struct fsm_frozen *frozen = fsm_frozen_layout(buffer, fsm->states_num, events_num);
+    fsm_trigger_t *triggers = (fsm_trigger_t *)frozen->triggers;
+    fsm_callback_t *execute = (fsm_callback_t *)frozen->execute;
+    fsm_callback_t *actions = (fsm_callback_t *)frozen->actions;
+    struct fsm_frozen_cold *cold = (struct fsm_frozen_cold *)frozen->cold;
+    struct fsm_frozen_state *states = (struct fsm_frozen_state *)frozen->states;
+    fsm_index_t *next = (fsm_index_t *)frozen->next;
+
+    uint16_t event = 0;
+
+    for(uint8_t k=0; k<fsm->states_num; k++) {
+        const struct fsm_state *state = &fsm->states[order[k]];
+
+        states[k].first = event;
+        states[k].events_num = state->events_num;
+        execute[k] = state->execute;
+        cold[k].enter = state->enter;
+        cold[k].exit = state->exit;
+        cold[k].id = state->id;
+
+        for(uint8_t j=0; j<state->events_num; j++) {
+            triggers[event] = state->events[j].trigger;
+            actions[event] = state->events[j].action;
+            next[event] = rank[state->events[j].next - fsm->states];
+            event++;
+        }
+    }
+
+    // builder arrays are not used anymore, the current state is tracked by index
+    if(fsm->current) {
+        fsm->index = rank[fsm->current - fsm->states];
+        fsm->current = NULL;
+    }
+
+    fsm->frozen = frozen;
+
+    return size_needed;
+}
+
 void fsm_start(fsm_t *fsm, uint8_t initial) {
+    if(fsm->frozen) {
+        fsm->index = fsm_frozen_start(fsm->frozen, fsm->context, initial);
+        return;
+    }
+
     struct fsm_state *initial_state = find_state(fsm, initial);
 
     assert(initial_state);
@@ -51,7 +203,12 @@ void fsm_start(fsm_t *fsm, uint8_t initial) {
     }
 }
 
-void fsm_update(fsm_t *fsm) {
+// returns true when a transition was taken
+bool fsm_update(fsm_t *fsm) {
+    if(fsm->frozen) {
+        return fsm_frozen_update(fsm->frozen, &fsm->index, fsm->context);
+    }
+
     assert(fsm->current);
 
 	struct fsm_event *event = NULL;
@@ -83,12 +240,86 @@ void fsm_update(fsm_t *fsm) {
             fsm->current->enter(fsm->context);
         }
     }
+
+    return event!=NULL;
 }
 
 void fsm_execute(fsm_t *fsm) {
+    if(fsm->frozen) {
+        fsm_frozen_execute(fsm->frozen, fsm->index, fsm->context);
+        return;
+    }
+
     assert(fsm->current);
 
 	if(fsm->current->execute) {
         fsm->current->execute(fsm->context);
     }
 }
+
+// returns the index of initial, many instances can run one frozen machine since it is read-only
+fsm_index_t fsm_frozen_start(const struct fsm_frozen *frozen, void *context, uint8_t initial) {
+    for(uint16_t i=0; i<frozen->states_num; i++) {
+        if(frozen->cold[i].id==initial) {
+            if(frozen->cold[i].enter) {
+                frozen->cold[i].enter(context);
+            }
+
+            return i;
+        }
+    }
+
+    assert(false);
+
+    return 0;
+}
+
+bool fsm_frozen_update(const struct fsm_frozen *frozen, fsm_index_t *index, void *context) {
+    const struct fsm_frozen_state *state = &frozen->states[*index];
+    const fsm_trigger_t *triggers = &frozen->triggers[state->first];
+
+    for(uint8_t i=0; i<state->events_num; i++) {
+        if(!triggers[i] || triggers[i](context)) {
+            const uint16_t event = state->first + i;
+            const fsm_index_t next = frozen->next[event];
+
+            if(frozen->cold[*index].exit) {
+                frozen->cold[*index].exit(context);
+            }
+
+            if(frozen->actions[event]) {
+                frozen->actions[event](context);
+            }
+
+            *index = next;
+
+            if(frozen->cold[next].enter) {
+                frozen->cold[next].enter(context);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void fsm_frozen_execute(const struct fsm_frozen *frozen, fsm_index_t index, void *context) {
+    if(frozen->execute[index]) {
+        frozen->execute[index](context);
+    }
+}
+
+void fsm_instance_start(fsm_instance_t *instance, const struct fsm_frozen *frozen, void *context, uint8_t initial) {
+    instance->frozen = frozen;
+    instance->context = context;
+    instance->index = fsm_frozen_start(frozen, context, initial);
+}
+
+bool fsm_instance_update(fsm_instance_t *instance) {
+    return fsm_frozen_update(instance->frozen, &instance->index, instance->context);
+}
+
+void fsm_instance_execute(fsm_instance_t *instance) {
+    fsm_frozen_execute(instance->frozen, instance->index, instance->context);
+}
@@ -0,0 +1,108 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "fsm/actor.h"
+
+#define MASK    (FSM_ACTOR_MAILBOX_SIZE - 1)
+
+_Static_assert((FSM_ACTOR_MAILBOX_SIZE & MASK)==0, "FSM_ACTOR_MAILBOX_SIZE must be a power of two");
+
+// actor whose step runs on this thread, it is the sender of what the step sends
+static _Thread_local fsm_actor_t *current;
+
+// a cell is free for the producer at position p when its sequence is p, and full for the
+// consumer when it is p + 1
+static bool mailbox_pop(fsm_actor_t *actor, struct fsm_message *message) {
+    struct fsm_actor_cell *cell = &actor->cells[actor->head & MASK];
+
+    if(atomic_load_explicit(&cell->sequence, memory_order_acquire)!=actor->head + 1) {
+        return false;
+    }
+
+    *message = cell->message;
+    atomic_store_explicit(&cell->sequence, actor->head + FSM_ACTOR_MAILBOX_SIZE, memory_order_release);
+    actor->head++;
+
+    return true;
+}
+
+static bool mailbox_empty(fsm_actor_t *actor) {
+    const struct fsm_actor_cell *cell = &actor->cells[actor->head & MASK];
+
+    return atomic_load_explicit(&cell->sequence, memory_order_acquire)!=actor->head + 1;
+}
+
+void fsm_actor_step(fsm_t *fsm, void *arg) {
+    fsm_actor_t *actor = (fsm_actor_t *)fsm;
+    fsm_actor_t *previous = current;
+    struct fsm_message message;
+
+    (void)arg;
+
+    current = actor;
+
+    for(uint16_t i=0; i<FSM_ACTOR_BATCH && mailbox_pop(actor, &message); i++) {
+        if(actor->deliver) {
+            actor->deliver(actor, &message);
+        } else {
+            *(struct fsm_message *)fsm->context = message;
+            fsm_update(fsm);
+            fsm_execute(fsm);
+        }
+    }
+
+    current = previous;
+
+    if(!mailbox_empty(actor)) {
+        fsm_runtime_notify(actor->runtime, actor->id);
+    }
+}
+
+// states and transitions have to be added to actor->fsm before
+void fsm_actor_spawn(fsm_actor_t *actor, fsm_runtime_t *runtime, uint8_t initial) {
+    assert(actor->fsm.context || actor->deliver);
+
+    actor->runtime = runtime;
+    actor->head = 0;
+    atomic_init(&actor->tail, 0);
+
+    for(uint32_t i=0; i<FSM_ACTOR_MAILBOX_SIZE; i++) {
+        atomic_init(&actor->cells[i].sequence, i);
+    }
+
+    fsm_start(&actor->fsm, initial);
+
+    actor->id = fsm_runtime_add(runtime, &actor->fsm);
+}
+
+// thread-safe, returns false when the target's mailbox is full
+bool fsm_send(fsm_actor_t *target, uint16_t event, void *payload) {
+    uint32_t position = atomic_load_explicit(&target->tail, memory_order_relaxed);
+    struct fsm_actor_cell *cell;
+
+    for(;;) {
+        cell = &target->cells[position & MASK];
+
+        const int32_t difference = (int32_t)(atomic_load_explicit(&cell->sequence, memory_order_acquire) - position);
+
+        if(difference==0) {
+            if(atomic_compare_exchange_weak_explicit(&target->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if(difference<0) {
+            return false;
+        } else {
+            position = atomic_load_explicit(&target->tail, memory_order_relaxed);
+        }
+    }
+
+    cell->message.event = event;
+    cell->message.payload = payload;
+    cell->message.sender = current;
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+
+    fsm_runtime_notify(target->runtime, target->id);
+
+    return true;
+}
@@ -0,0 +1,129 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "fsm/atomic.h"
+#include "fsm/wait.h"
+
+_Static_assert(FSM_STATE_MAX_NUM<=FSM_ATOMIC_COMMITTING, "state indexes must leave the committing bit free");
+
+struct transition {
+    uint16_t next;
+    fsm_callback_t action;
+};
+
+// first event whose trigger fires in state index, same order as fsm_update()
+static bool find_transition(const fsm_t *fsm, uint16_t index, struct transition *transition) {
+    if(fsm->frozen) {
+        const struct fsm_frozen *frozen = fsm->frozen;
+        const struct fsm_frozen_state *state = &frozen->states[index];
+
+        for(uint8_t i=0; i<state->events_num; i++) {
+            const uint16_t event = state->first + i;
+
+            if(!frozen->triggers[event] || frozen->triggers[event](fsm->context)) {
+                transition->next = frozen->next[event];
+                transition->action = frozen->actions[event];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const struct fsm_state *state = &fsm->states[index];
+
+    for(uint8_t i=0; i<state->events_num; i++) {
+        const struct fsm_event *event = &state->events[i];
+
+        if(!event->trigger || event->trigger(fsm->context)) {
+            transition->next = event->next - fsm->states;
+            transition->action = event->action;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static fsm_callback_t enter_of(const fsm_t *fsm, uint16_t index) {
+    return fsm->frozen ? fsm->frozen->cold[index].enter : fsm->states[index].enter;
+}
+
+static fsm_callback_t exit_of(const fsm_t *fsm, uint16_t index) {
+    return fsm->frozen ? fsm->frozen->cold[index].exit : fsm->states[index].exit;
+}
+
+void fsm_atomic_init(fsm_atomic_t *atomic, fsm_t *fsm) {
+    assert(fsm->frozen || fsm->current);
+
+    atomic->fsm = fsm;
+    atomic_init(&atomic->current, fsm->frozen ? fsm->index : (uint32_t)(fsm->current - fsm->states));
+    atomic_init(&atomic->waiters, 0);
+}
+
+// returns true when this call committed a transition
+bool fsm_atomic_update(fsm_atomic_t *atomic) {
+    const fsm_t *fsm = atomic->fsm;
+    uint32_t current = atomic_load_explicit(&atomic->current, memory_order_acquire);
+    const uint16_t index = FSM_ATOMIC_INDEX(current);
+    struct transition transition;
+
+    // another thread still runs the callbacks of its transition
+    if(current & FSM_ATOMIC_COMMITTING) {
+        return false;
+    }
+
+    if(!find_transition(fsm, index, &transition)) {
+        return false;
+    }
+
+    const uint32_t desired = (current & 0xffff0000) + 0x10000 + FSM_ATOMIC_COMMITTING + transition.next;
+
+    if(!atomic_compare_exchange_strong_explicit(&atomic->current, &current, desired, memory_order_acq_rel, memory_order_acquire)) {
+        return false;
+    }
+
+    const fsm_callback_t exit = exit_of(fsm, index);
+    const fsm_callback_t enter = enter_of(fsm, transition.next);
+
+    if(exit) {
+        exit(fsm->context);
+    }
+
+    if(transition.action) {
+        transition.action(fsm->context);
+    }
+
+    if(enter) {
+        enter(fsm->context);
+    }
+
+    // nobody else writes while the bit is set; sequentially consistent against the waiters
+    // count, see fsm_wait_change()
+    atomic_store(&atomic->current, desired & ~(uint32_t)FSM_ATOMIC_COMMITTING);
+
+    if(atomic_load(&atomic->waiters)) {
+        fsm_wait_wake(atomic);
+    }
+
+    return true;
+}
+
+// runs the execute callback of the state current at the time of the call
+void fsm_atomic_execute(fsm_atomic_t *atomic) {
+    const fsm_t *fsm = atomic->fsm;
+    const uint16_t index = FSM_ATOMIC_INDEX(atomic_load_explicit(&atomic->current, memory_order_acquire));
+    const fsm_callback_t execute = fsm->frozen ? fsm->frozen->execute[index] : fsm->states[index].execute;
+
+    if(execute) {
+        execute(fsm->context);
+    }
+}
+
+uint8_t fsm_atomic_state(fsm_atomic_t *atomic) {
+    const fsm_t *fsm = atomic->fsm;
+    const uint16_t index = FSM_ATOMIC_INDEX(atomic_load_explicit(&atomic->current, memory_order_acquire));
+
+    return fsm->frozen ? fsm->frozen->cold[index].id : fsm->states[index].id;
+}
@@ -0,0 +1,196 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "fsm/builder.h"
+
+// NULL when out of memory, array and cap are left as they were then
+static void * grow(void *array, size_t size, uint32_t *cap, uint32_t needed) {
+    if(needed<=*cap) {
+        return array;
+    }
+
+    uint32_t new_cap = *cap ? *cap : 16;
+
+    while(new_cap<needed) {
+        new_cap *=2;
+    }
+
+    array = realloc(array, new_cap*size);
+
+    if(array) {
+        *cap = new_cap;
+    }
+
+    return array;
+}
+
+// false for an id no state was added with
+static bool find_state(const fsm_builder_t *builder, uint8_t id, uint16_t *position) {
+    for(uint16_t i=0; i<builder->states_num; i++) {
+        if(builder->states[i].id==id) {
+            *position = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// a failed call leaves the machine as it was and makes fsm_builder_build() fail
+static bool fail(fsm_builder_t *builder) {
+    builder->failed = true;
+
+    return false;
+}
+
+void fsm_arena_init(fsm_arena_t *arena, void *buffer, size_t size) {
+    arena->base = buffer;
+    arena->size = size;
+    arena->used = 0;
+}
+
+// alignment is a power of two, returns NULL when the arena is exhausted
+void * fsm_arena_alloc(fsm_arena_t *arena, size_t size, size_t alignment) {
+    const uintptr_t address = (uintptr_t)(arena->base + arena->used);
+    const size_t padding = (size_t)(-address & (alignment - 1));
+
+    if(size + padding>arena->size - arena->used) {
+        return NULL;
+    }
+
+    arena->used +=padding + size;
+
+    return (void *)(address + padding);
+}
+
+// every block allocated so far becomes invalid
+void fsm_arena_reset(fsm_arena_t *arena) {
+    arena->used = 0;
+}
+
+// false for an id already added, for a 257th state and when out of memory
+bool fsm_builder_add_state(fsm_builder_t *builder, uint8_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit) {
+    uint16_t position;
+
+    if(builder->states_num==256 || find_state(builder, id, &position)) {
+        return fail(builder);
+    }
+
+    struct fsm_builder_state *states = grow(builder->states, sizeof(struct fsm_builder_state), &builder->states_cap, builder->states_num + 1);
+
+    if(!states) {
+        return fail(builder);
+    }
+
+    builder->states = states;
+
+    builder->states[builder->states_num].id = id;
+    builder->states[builder->states_num].enter = enter;
+    builder->states[builder->states_num].execute = execute;
+    builder->states[builder->states_num].exit = exit;
+    builder->states[builder->states_num].events_num = 0;
+    builder->states_num++;
+
+    return true;
+}
+
+// transitions of a state are tried in the order they were added, at most 255 per state;
+// false for a state id not added yet, for too many transitions and when out of memory
+bool fsm_builder_add_transition(fsm_builder_t *builder, uint8_t from, uint8_t to, fsm_trigger_t trigger, fsm_callback_t action) {
+    uint16_t from_state;
+    uint16_t to_state;
+
+    if(!find_state(builder, from, &from_state) || !find_state(builder, to, &to_state)) {
+        return fail(builder);
+    }
+
+    if(builder->states[from_state].events_num==UINT8_MAX || builder->transitions_num==UINT16_MAX) {
+        return fail(builder);
+    }
+
+    struct fsm_builder_transition *transitions = grow(builder->transitions, sizeof(struct fsm_builder_transition),
+        &builder->transitions_cap, builder->transitions_num + 1);
+
+    if(!transitions) {
+        return fail(builder);
+    }
+
+    builder->transitions = transitions;
+
+    builder->transitions[builder->transitions_num].from = from_state;
+    builder->transitions[builder->transitions_num].to = to_state;
+    builder->transitions[builder->transitions_num].trigger = trigger;
+    builder->transitions[builder->transitions_num].action = action;
+    builder->transitions_num++;
+    builder->states[from_state].events_num++;
+
+    return true;
+}
+
+// exact bytes fsm_builder_build() takes from the arena, not counting alignment padding
+size_t fsm_builder_size(const fsm_builder_t *builder) {
+    return fsm_frozen_size(builder->states_num, builder->transitions_num);
+}
+
+// one contiguous block from the arena, NULL when it does not fit or an add call failed; the
+// builder can be freed or reused afterwards, the machine lives as long as the arena block
+const struct fsm_frozen * fsm_builder_build(const fsm_builder_t *builder, fsm_arena_t *arena) {
+    if(builder->failed) {
+        return NULL;
+    }
+
+    void *buffer = fsm_arena_alloc(arena, fsm_builder_size(builder), sizeof(void *));
+
+    if(!buffer) {
+        return NULL;
+    }
+
+    struct fsm_frozen *frozen = fsm_frozen_layout(buffer, builder->states_num, builder->transitions_num);
+    fsm_trigger_t *triggers = (fsm_trigger_t *)frozen->triggers;
+    fsm_callback_t *execute = (fsm_callback_t *)frozen->execute;
+    fsm_callback_t *actions = (fsm_callback_t *)frozen->actions;
+    struct fsm_frozen_cold *cold = (struct fsm_frozen_cold *)frozen->cold;
+    struct fsm_frozen_state *states = (struct fsm_frozen_state *)frozen->states;
+    fsm_index_t *next = (fsm_index_t *)frozen->next;
+
+    uint16_t first = 0;
+
+    for(uint16_t i=0; i<builder->states_num; i++) {
+        const struct fsm_builder_state *state = &builder->states[i];
+
+        states[i].first = first;
+        states[i].events_num = 0;
+        execute[i] = state->execute;
+        cold[i].enter = state->enter;
+        cold[i].exit = state->exit;
+        cold[i].id = state->id;
+
+        first +=state->events_num;
+    }
+
+    // states[].events_num counts the placed ones until every transition is in
+    for(uint32_t t=0; t<builder->transitions_num; t++) {
+        const struct fsm_builder_transition *transition = &builder->transitions[t];
+        const uint16_t event = states[transition->from].first + states[transition->from].events_num++;
+
+        triggers[event] = transition->trigger;
+        actions[event] = transition->action;
+        next[event] = transition->to;
+    }
+
+    return frozen;
+}
+
+void fsm_builder_free(fsm_builder_t *builder) {
+    free(builder->states);
+    free(builder->transitions);
+
+    builder->states = NULL;
+    builder->states_num = 0;
+    builder->states_cap = 0;
+    builder->transitions = NULL;
+    builder->transitions_num = 0;
+    builder->transitions_cap = 0;
+    builder->failed = false;
+}
@@ -0,0 +1,112 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <sched.h>
+
+#include "fsm/combine.h"
+
+// spins before a waiter gives its core away, the combiner may be the one waiting for it
+#define SPINS_PER_YIELD 64
+
+static inline void relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void deliver(fsm_combine_t *combine, const struct fsm_message *message) {
+    if(combine->deliver) {
+        combine->deliver(combine->fsm, message);
+        return;
+    }
+
+    *(struct fsm_message *)combine->fsm->context = *message;
+    fsm_update(combine->fsm);
+    fsm_execute(combine->fsm);
+}
+
+// one pass over all registered slots, the machine stays in this core's cache throughout;
+// returns the number of events delivered
+static uint32_t combine_pass(fsm_combine_t *combine) {
+    const uint32_t slots_num = atomic_load_explicit(&combine->slots_num, memory_order_acquire);
+    uint32_t delivered = 0;
+
+    for(uint32_t i=0; i<slots_num; i++) {
+        struct fsm_combine_slot *slot = &combine->slots[i];
+
+        if(atomic_load_explicit(&slot->pending, memory_order_acquire)) {
+            deliver(combine, &slot->message);
+            atomic_store_explicit(&slot->pending, 0, memory_order_release);
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+// passes until one finds nothing pending or FSM_COMBINE_PASS_MAX_NUM are done, so events
+// published while the lock is held are served by the same combiner
+static void combine_all(fsm_combine_t *combine) {
+    for(uint32_t pass=0; pass<FSM_COMBINE_PASS_MAX_NUM; pass++) {
+        const uint32_t delivered = combine_pass(combine);
+
+        if(!delivered) {
+            break;
+        }
+
+        combine->delivered +=delivered;
+        combine->passes++;
+    }
+}
+
+void fsm_combine_init(fsm_combine_t *combine, fsm_t *fsm, fsm_combine_deliver_t deliver) {
+    assert(fsm->context || deliver);
+
+    combine->fsm = fsm;
+    combine->deliver = deliver;
+    combine->passes = 0;
+    combine->delivered = 0;
+
+    atomic_init(&combine->locked, false);
+    atomic_init(&combine->slots_num, 0);
+
+    for(uint16_t i=0; i<FSM_COMBINE_SLOT_NUM; i++) {
+        atomic_init(&combine->slots[i].pending, 0);
+    }
+}
+
+// once per thread, the slot is that thread's for good
+uint16_t fsm_combine_register(fsm_combine_t *combine) {
+    const uint32_t slot = atomic_fetch_add(&combine->slots_num, 1);
+
+    assert(slot<FSM_COMBINE_SLOT_NUM);
+
+    return slot;
+}
+
+// returns once the event went through fsm_update(), events of one thread keep their order
+void fsm_combine_dispatch(fsm_combine_t *combine, uint16_t slot, uint16_t event, void *payload) {
+    struct fsm_combine_slot *own = &combine->slots[slot];
+
+    assert(slot<atomic_load_explicit(&combine->slots_num, memory_order_relaxed));
+
+    own->message.event = event;
+    own->message.payload = payload;
+    own->message.sender = NULL;
+    atomic_store_explicit(&own->pending, 1, memory_order_release);
+
+    for(uint32_t spins=1; atomic_load_explicit(&own->pending, memory_order_acquire); spins++) {
+        if(!atomic_load_explicit(&combine->locked, memory_order_relaxed)
+            && !atomic_exchange_explicit(&combine->locked, true, memory_order_acquire)) {
+            combine_all(combine);
+            atomic_store_explicit(&combine->locked, false, memory_order_release);
+            return;
+        }
+
+        if(spins%SPINS_PER_YIELD) {
+            relax();
+        } else {
+            sched_yield();
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fsm/dfa.h"
+
+#define TABLE_SIZE  (2*FSM_DFA_CACHE_NUM)
+
+static uint16_t words_num(const fsm_nfa_t *nfa) {
+    return (nfa->states_num + 63)/64;
+}
+
+static bool set_accepting(const fsm_nfa_t *nfa, const fsm_nfa_set_t *set) {
+    for(uint16_t w=0; w<words_num(nfa); w++) {
+        if(set->bits[w] & nfa->accepting.bits[w]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t hash(const fsm_nfa_t *nfa, const fsm_nfa_set_t *set) {
+    uint64_t h = 0xcbf29ce484222325;
+
+    for(uint16_t w=0; w<words_num(nfa); w++) {
+        h = (h ^ set->bits[w])*0x100000001b3;
+    }
+
+    return (uint32_t)(h ^ (h>>32));
+}
+
+static bool set_equal(const fsm_nfa_t *nfa, const fsm_nfa_set_t *a, const fsm_nfa_set_t *b) {
+    return !memcmp(a->bits, b->bits, words_num(nfa)*sizeof(uint64_t));
+}
+
+static void flush(fsm_dfa_t *dfa) {
+    dfa->states_num = 0;
+    dfa->since_flush = 0;
+
+    for(uint16_t i=0; i<TABLE_SIZE; i++) {
+        dfa->table[i] = FSM_DFA_NONE;
+    }
+}
+
+// returns FSM_DFA_NONE when the set is not cached and the cache is full
+static uint16_t find_or_insert(fsm_dfa_t *dfa, const fsm_nfa_set_t *set) {
+    uint32_t slot = hash(dfa->nfa, set)%TABLE_SIZE;
+
+    while(dfa->table[slot]!=FSM_DFA_NONE) {
+        if(set_equal(dfa->nfa, &dfa->states[dfa->table[slot]].set, set)) {
+            return dfa->table[slot];
+        }
+
+        slot = (slot + 1)%TABLE_SIZE;
+    }
+
+    if(dfa->states_num==FSM_DFA_CACHE_NUM) {
+        return FSM_DFA_NONE;
+    }
+
+    const uint16_t index = dfa->states_num++;
+    struct fsm_dfa_state *state = &dfa->states[index];
+
+    state->set = *set;
+    state->accepting = set_accepting(dfa->nfa, set);
+
+    for(uint8_t e=0; e<FSM_NFA_EVENT_MAX_NUM; e++) {
+        state->next[e] = FSM_DFA_NONE;
+    }
+
+    dfa->table[slot] = index;
+
+    return index;
+}
+
+// cache is full: start over, unless it was flushed only recently and keeps thrashing
+static void enter_set(fsm_dfa_t *dfa, const fsm_nfa_set_t *set) {
+    const bool thrashing = dfa->since_flush<FSM_DFA_THRASH_STEPS;
+
+    dfa->flushes++;
+    flush(dfa);
+
+    if(thrashing) {
+        dfa->current = FSM_DFA_NONE;
+        dfa->set = *set;
+        dfa->fallback = FSM_DFA_FALLBACK_STEPS;
+        return;
+    }
+
+    dfa->current = find_or_insert(dfa, set);
+}
+
+static void miss(fsm_dfa_t *dfa, uint8_t event) {
+    fsm_nfa_set_t set;
+
+    dfa->misses++;
+
+    fsm_nfa_step(dfa->nfa, &dfa->states[dfa->current].set, event, &set);
+
+    const uint16_t next = find_or_insert(dfa, &set);
+
+    if(next==FSM_DFA_NONE) {
+        enter_set(dfa, &set);
+        return;
+    }
+
+    dfa->states[dfa->current].next[event] = next;
+    dfa->current = next;
+}
+
+static void fallback_step(fsm_dfa_t *dfa, uint8_t event) {
+    dfa->fallback_steps++;
+
+    fsm_nfa_step(dfa->nfa, &dfa->set, event, &dfa->set);
+
+    if(--dfa->fallback==0) {
+        dfa->current = find_or_insert(dfa, &dfa->set);
+    }
+}
+
+void fsm_dfa_start(fsm_dfa_t *dfa, const fsm_nfa_t *nfa, uint16_t initial) {
+    assert(nfa->compiled);
+    assert(initial<nfa->states_num);
+
+    dfa->nfa = nfa;
+    dfa->hits = 0;
+    dfa->misses = 0;
+    dfa->flushes = 0;
+    dfa->fallback_steps = 0;
+
+    flush(dfa);
+
+    dfa->current = find_or_insert(dfa, &nfa->closure[initial]);
+}
+
+void fsm_dfa_dispatch(fsm_dfa_t *dfa, uint8_t event) {
+    assert(event<FSM_NFA_EVENT_MAX_NUM);
+
+    dfa->since_flush++;
+
+    if(dfa->current==FSM_DFA_NONE) {
+        fallback_step(dfa, event);
+        return;
+    }
+
+    const uint16_t next = dfa->states[dfa->current].next[event];
+
+    if(next==FSM_DFA_NONE) {
+        miss(dfa, event);
+        return;
+    }
+
+    dfa->hits++;
+    dfa->current = next;
+}
+
+void fsm_dfa_feed(fsm_dfa_t *dfa, const uint8_t *events, size_t len) {
+    size_t i = 0;
+
+    while(i<len) {
+        // hot path, cached transitions only
+        if(dfa->current!=FSM_DFA_NONE) {
+            const struct fsm_dfa_state *states = dfa->states;
+            uint16_t current = dfa->current;
+            const size_t begin = i;
+
+            while(i<len) {
+                assert(events[i]<FSM_NFA_EVENT_MAX_NUM);
+
+                const uint16_t next = states[current].next[events[i]];
+
+                if(next==FSM_DFA_NONE) {
+                    break;
+                }
+
+                current = next;
+                i++;
+            }
+
+            dfa->current = current;
+            dfa->hits +=i - begin;
+            dfa->since_flush +=i - begin;
+        }
+
+        if(i<len) {
+            fsm_dfa_dispatch(dfa, events[i++]);
+        }
+    }
+}
+
+bool fsm_dfa_accepts(const fsm_dfa_t *dfa) {
+    if(dfa->current==FSM_DFA_NONE) {
+        return set_accepting(dfa->nfa, &dfa->set);
+    }
+
+    return dfa->states[dfa->current].accepting;
+}
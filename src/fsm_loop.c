@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <time.h>
+
+#include "fsm/loop.h"
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000 + (uint64_t)ts.tv_nsec/1000000;
+}
+
+static void dispatch(fsm_loop_t *loop) {
+    fsm_update(loop->fsm);
+    fsm_execute(loop->fsm);
+}
+
+void fsm_loop_add_source(fsm_loop_t *loop, int fd, fsm_loop_read_t read) {
+    assert(loop->sources_num<FSM_LOOP_SOURCE_MAX_NUM);
+    assert(read);
+
+    loop->sources[loop->sources_num].fd = fd;
+    loop->sources[loop->sources_num].read = read;
+    loop->sources_num++;
+}
+
+void fsm_loop_add_timer(fsm_loop_t *loop, uint32_t period_ms, fsm_callback_t callback) {
+    assert(loop->timers_num<FSM_LOOP_TIMER_MAX_NUM);
+    assert(period_ms>0);
+
+    loop->timers[loop->timers_num].period = period_ms;
+    loop->timers[loop->timers_num].deadline = now_ms() + period_ms;
+    loop->timers[loop->timers_num].callback = callback;
+    loop->timers_num++;
+}
+
+// returns 0 once fsm_loop_stop() was called, -1 with errno set when poll() fails
+int fsm_loop_run(fsm_loop_t *loop) {
+    assert(loop->fsm);
+
+    struct pollfd fds[FSM_LOOP_SOURCE_MAX_NUM];
+
+    for(uint8_t i=0; i<loop->sources_num; i++) {
+        fds[i].fd = loop->sources[i].fd;
+        fds[i].events = POLLIN;
+    }
+
+    loop->running = true;
+
+    while(loop->running) {
+        int timeout = -1;
+
+        if(loop->timers_num) {
+            const uint64_t now = now_ms();
+            uint64_t nearest = UINT64_MAX;
+
+            for(uint8_t i=0; i<loop->timers_num; i++) {
+                if(loop->timers[i].deadline<nearest) {
+                    nearest = loop->timers[i].deadline;
+                }
+            }
+
+            if(nearest<=now) {
+                timeout = 0;
+            } else if(nearest - now>INT_MAX) {
+                timeout = INT_MAX;
+            } else {
+                timeout = (int)(nearest - now);
+            }
+        }
+
+        // sleeps until input arrives or the nearest timer expires
+        const int ready = poll(fds, loop->sources_num, timeout);
+
+        if(ready<0) {
+            if(errno==EINTR) {
+                continue;
+            }
+
+            loop->running = false;
+            return -1;
+        }
+
+        for(uint8_t i=0; i<loop->sources_num && loop->running; i++) {
+            if(fds[i].revents) {
+                if(loop->sources[i].read(loop->fsm->context, fds[i].fd)) {
+                    dispatch(loop);
+                }
+            }
+        }
+
+        const uint64_t now = now_ms();
+
+        for(uint8_t i=0; i<loop->timers_num && loop->running; i++) {
+            if(loop->timers[i].deadline<=now) {
+                loop->timers[i].deadline += loop->timers[i].period;
+
+                if(loop->timers[i].callback) {
+                    loop->timers[i].callback(loop->fsm->context);
+                }
+
+                dispatch(loop);
+            }
+        }
+    }
+
+    return 0;
+}
+
+void fsm_loop_stop(fsm_loop_t *loop) {
+    loop->running = false;
+}
@@ -0,0 +1,457 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fsm/minimize.h"
+
+#define NONE    UINT32_MAX
+
+// refinable partition of 0..n-1, every set is a range of elements[], marked elements are moved
+// to the front of their set and split off by partition_split() (Valmari-Lehtinen)
+struct partition {
+    uint32_t sets_num;
+    uint32_t *elements;
+    uint32_t *location;
+    uint32_t *set;
+    uint32_t *first;
+    uint32_t *past;
+    uint32_t *marked;
+    uint32_t *touched;
+    uint32_t touched_num;
+};
+
+struct transition_key {
+    uint16_t from;
+    uint16_t event;
+    uint32_t index;
+};
+
+struct label_key {
+    uint16_t event;
+    fsm_callback_t action;
+    uint32_t transition;
+};
+
+struct state_key {
+    struct fsm_table_state callbacks;
+    uint32_t state;
+};
+
+static void * alloc(size_t num, size_t size) {
+    void *array = malloc((num ? num : 1)*size);
+    assert(array);
+
+    return array;
+}
+
+static int compare_transitions(const void *a, const void *b) {
+    const struct transition_key *x = a;
+    const struct transition_key *y = b;
+
+    if(x->from!=y->from) {
+        return x->from<y->from ? -1 : 1;
+    }
+
+    if(x->event!=y->event) {
+        return x->event<y->event ? -1 : 1;
+    }
+
+    return x->index<y->index ? -1 : (x->index>y->index);
+}
+
+static int compare_labels(const void *a, const void *b) {
+    const struct label_key *x = a;
+    const struct label_key *y = b;
+
+    if(x->event!=y->event) {
+        return x->event<y->event ? -1 : 1;
+    }
+
+    return memcmp(&x->action, &y->action, sizeof(fsm_callback_t));
+}
+
+static int compare_states(const void *a, const void *b) {
+    const struct state_key *x = a;
+    const struct state_key *y = b;
+
+    return memcmp(&x->callbacks, &y->callbacks, sizeof(struct fsm_table_state));
+}
+
+// group[] holds dense set ids 0..groups_num-1, all of them used
+static void partition_init(struct partition *p, uint32_t n, const uint32_t *group, uint32_t groups_num) {
+    p->sets_num = groups_num;
+    p->elements = alloc(n, sizeof(uint32_t));
+    p->location = alloc(n, sizeof(uint32_t));
+    p->set = alloc(n, sizeof(uint32_t));
+    p->first = alloc(n, sizeof(uint32_t));
+    p->past = alloc(n, sizeof(uint32_t));
+    p->marked = calloc(n ? n : 1, sizeof(uint32_t));
+    p->touched = alloc(n, sizeof(uint32_t));
+    p->touched_num = 0;
+    assert(p->marked);
+
+    memset(p->past, 0, (n ? n : 1)*sizeof(uint32_t));
+
+    for(uint32_t e=0; e<n; e++) {
+        p->past[group[e]]++;
+    }
+
+    for(uint32_t s=0, begin=0; s<groups_num; s++) {
+        p->first[s] = begin;
+        begin +=p->past[s];
+        p->past[s] = p->first[s];
+    }
+
+    for(uint32_t e=0; e<n; e++) {
+        const uint32_t i = p->past[group[e]]++;
+
+        p->elements[i] = e;
+        p->location[e] = i;
+        p->set[e] = group[e];
+    }
+}
+
+static void partition_free(struct partition *p) {
+    free(p->elements);
+    free(p->location);
+    free(p->set);
+    free(p->first);
+    free(p->past);
+    free(p->marked);
+    free(p->touched);
+}
+
+static void partition_mark(struct partition *p, uint32_t e) {
+    const uint32_t s = p->set[e];
+    const uint32_t i = p->location[e];
+    const uint32_t j = p->first[s] + p->marked[s];
+
+    p->elements[i] = p->elements[j];
+    p->location[p->elements[i]] = i;
+    p->elements[j] = e;
+    p->location[e] = j;
+
+    if(!p->marked[s]++) {
+        p->touched[p->touched_num++] = s;
+    }
+}
+
+// the smaller half of every touched set becomes the new set
+static void partition_split(struct partition *p) {
+    while(p->touched_num) {
+        const uint32_t s = p->touched[--p->touched_num];
+        const uint32_t j = p->first[s] + p->marked[s];
+        const uint32_t z = p->sets_num;
+
+        if(j==p->past[s]) {
+            p->marked[s] = 0;
+            continue;
+        }
+
+        if(p->marked[s]<=p->past[s] - j) {
+            p->first[z] = p->first[s];
+            p->past[z] = p->first[s] = j;
+        } else {
+            p->past[z] = p->past[s];
+            p->first[z] = p->past[s] = j;
+        }
+
+        for(uint32_t i=p->first[z]; i<p->past[z]; i++) {
+            p->set[p->elements[i]] = z;
+        }
+
+        p->marked[s] = 0;
+        p->marked[z] = 0;
+        p->sets_num++;
+    }
+}
+
+// only the first transition of every (from, event) pair is taken by fsm_table_dispatch()
+static bool * first_transitions(const fsm_table_t *table) {
+    const uint32_t n = table->transitions_num;
+    struct transition_key *keys = alloc(n, sizeof(struct transition_key));
+    bool *first = calloc(n ? n : 1, sizeof(bool));
+    assert(first);
+
+    for(uint32_t t=0; t<n; t++) {
+        keys[t].from = table->transitions[t].from;
+        keys[t].event = table->transitions[t].event;
+        keys[t].index = t;
+    }
+
+    qsort(keys, n, sizeof(struct transition_key), compare_transitions);
+
+    for(uint32_t t=0; t<n; t++) {
+        first[keys[t].index] = !t || keys[t].from!=keys[t - 1].from || keys[t].event!=keys[t - 1].event;
+    }
+
+    free(keys);
+
+    return first;
+}
+
+// dense[] gets old id -> reachable index in old id order, returns the reachable count
+static uint32_t reachable_states(const fsm_table_t *table, const bool *first, uint16_t initial, uint32_t *dense) {
+    const uint32_t states_num = table->states_num;
+    uint32_t *begin = calloc(states_num + 1, sizeof(uint32_t));
+    uint32_t *targets = alloc(table->transitions_num, sizeof(uint32_t));
+    uint32_t *queue = alloc(states_num, sizeof(uint32_t));
+    assert(begin);
+
+    for(uint32_t t=0; t<table->transitions_num; t++) {
+        if(first[t]) {
+            begin[table->transitions[t].from + 1]++;
+        }
+    }
+
+    for(uint32_t s=0; s<states_num; s++) {
+        begin[s + 1] +=begin[s];
+    }
+
+    for(uint32_t t=0; t<table->transitions_num; t++) {
+        if(first[t]) {
+            targets[begin[table->transitions[t].from]++] = table->transitions[t].to;
+        }
+    }
+
+    for(uint32_t s=states_num; s>0; s--) {
+        begin[s] = begin[s - 1];
+    }
+
+    begin[0] = 0;
+
+    for(uint32_t s=0; s<states_num; s++) {
+        dense[s] = NONE;
+    }
+
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    dense[initial] = 0;
+    queue[tail++] = initial;
+
+    while(head<tail) {
+        const uint32_t s = queue[head++];
+
+        for(uint32_t i=begin[s]; i<begin[s + 1]; i++) {
+            if(dense[targets[i]]==NONE) {
+                dense[targets[i]] = 0;
+                queue[tail++] = targets[i];
+            }
+        }
+    }
+
+    uint32_t reachable_num = 0;
+
+    for(uint32_t s=0; s<states_num; s++) {
+        if(dense[s]!=NONE) {
+            dense[s] = reachable_num++;
+        }
+    }
+
+    free(begin);
+    free(targets);
+    free(queue);
+
+    return reachable_num;
+}
+
+uint16_t fsm_minimize(fsm_table_t *table, uint16_t initial, uint16_t *map, struct fsm_minimize_report *report) {
+    assert(!table->actions);
+    assert(initial<table->states_num);
+
+    const uint16_t states_before = table->states_num;
+    const size_t bytes_before = fsm_table_bytes(table);
+
+    bool *first = first_transitions(table);
+    uint32_t *dense = alloc(states_before, sizeof(uint32_t));
+    const uint32_t n = reachable_states(table, first, initial, dense);
+
+    // transitions left after dropping shadowed ones and those of unreachable states
+    uint32_t *original = alloc(table->transitions_num, sizeof(uint32_t));
+    uint32_t m = 0;
+
+    for(uint32_t t=0; t<table->transitions_num; t++) {
+        if(first[t] && dense[table->transitions[t].from]!=NONE) {
+            original[m++] = t;
+        }
+    }
+
+    uint32_t *tail = alloc(m, sizeof(uint32_t));
+    uint32_t *head = alloc(m, sizeof(uint32_t));
+
+    for(uint32_t t=0; t<m; t++) {
+        tail[t] = dense[table->transitions[original[t]].from];
+        head[t] = dense[table->transitions[original[t]].to];
+    }
+
+    // blocks start grouped by callbacks
+    uint32_t *old = alloc(n, sizeof(uint32_t));
+    struct state_key *state_keys = alloc(n, sizeof(struct state_key));
+    uint32_t *group = alloc(n>m ? n : m, sizeof(uint32_t));
+    uint32_t groups_num = 0;
+
+    for(uint32_t s=0; s<states_before; s++) {
+        if(dense[s]!=NONE) {
+            old[dense[s]] = s;
+            state_keys[dense[s]].callbacks = table->states[s];
+            state_keys[dense[s]].state = dense[s];
+        }
+    }
+
+    qsort(state_keys, n, sizeof(struct state_key), compare_states);
+
+    for(uint32_t i=0; i<n; i++) {
+        if(i && compare_states(&state_keys[i], &state_keys[i - 1])) {
+            groups_num++;
+        }
+
+        group[state_keys[i].state] = groups_num;
+    }
+
+    struct partition blocks;
+    partition_init(&blocks, n, group, groups_num + 1);
+    free(state_keys);
+
+    // cords start grouped by (event, action)
+    struct label_key *label_keys = alloc(m, sizeof(struct label_key));
+
+    for(uint32_t t=0; t<m; t++) {
+        label_keys[t].event = table->transitions[original[t]].event;
+        label_keys[t].action = table->transitions[original[t]].action;
+        label_keys[t].transition = t;
+    }
+
+    qsort(label_keys, m, sizeof(struct label_key), compare_labels);
+    groups_num = 0;
+
+    for(uint32_t i=0; i<m; i++) {
+        if(i && compare_labels(&label_keys[i], &label_keys[i - 1])) {
+            groups_num++;
+        }
+
+        group[label_keys[i].transition] = groups_num;
+    }
+
+    struct partition cords;
+    partition_init(&cords, m, group, m ? groups_num + 1 : 0);
+    free(label_keys);
+    free(group);
+
+    // incoming transitions of every state
+    uint32_t *incoming_begin = calloc(n + 1, sizeof(uint32_t));
+    uint32_t *incoming = alloc(m, sizeof(uint32_t));
+    assert(incoming_begin);
+
+    for(uint32_t t=0; t<m; t++) {
+        incoming_begin[head[t] + 1]++;
+    }
+
+    for(uint32_t s=0; s<n; s++) {
+        incoming_begin[s + 1] +=incoming_begin[s];
+    }
+
+    for(uint32_t t=0; t<m; t++) {
+        incoming[incoming_begin[head[t]]++] = t;
+    }
+
+    for(uint32_t s=n; s>0; s--) {
+        incoming_begin[s] = incoming_begin[s - 1];
+    }
+
+    incoming_begin[0] = 0;
+
+    // every cord splits blocks by tail, every block but the first splits cords by head
+    uint32_t b = 1;
+    uint32_t c = 0;
+
+    while(c<cords.sets_num) {
+        for(uint32_t i=cords.first[c]; i<cords.past[c]; i++) {
+            partition_mark(&blocks, tail[cords.elements[i]]);
+        }
+
+        partition_split(&blocks);
+        c++;
+
+        while(b<blocks.sets_num) {
+            for(uint32_t i=blocks.first[b]; i<blocks.past[b]; i++) {
+                const uint32_t s = blocks.elements[i];
+
+                for(uint32_t j=incoming_begin[s]; j<incoming_begin[s + 1]; j++) {
+                    partition_mark(&cords, incoming[j]);
+                }
+            }
+
+            partition_split(&cords);
+            b++;
+        }
+    }
+
+    // new ids follow the lowest old id of every block, which is also its representative
+    uint32_t *renumber = alloc(blocks.sets_num, sizeof(uint32_t));
+    uint32_t *representative = alloc(blocks.sets_num, sizeof(uint32_t));
+    uint16_t states_after = 0;
+
+    for(uint32_t i=0; i<blocks.sets_num; i++) {
+        renumber[i] = NONE;
+    }
+
+    for(uint32_t s=0; s<n; s++) {
+        const uint32_t block = blocks.set[s];
+
+        if(renumber[block]==NONE) {
+            renumber[block] = states_after;
+            representative[block] = s;
+            table->states[states_after++] = table->states[old[s]];
+        }
+    }
+
+    uint32_t transitions_after = 0;
+
+    for(uint32_t t=0; t<m; t++) {
+        const uint32_t block = blocks.set[tail[t]];
+
+        if(representative[block]==tail[t]) {
+            struct fsm_table_transition transition = table->transitions[original[t]];
+
+            transition.from = renumber[block];
+            transition.to = renumber[blocks.set[head[t]]];
+            table->transitions[transitions_after++] = transition;
+        }
+    }
+
+    if(map) {
+        for(uint32_t s=0; s<states_before; s++) {
+            map[s] = (dense[s]==NONE) ? FSM_TABLE_NONE : renumber[blocks.set[dense[s]]];
+        }
+    }
+
+    const uint16_t result = renumber[blocks.set[dense[initial]]];
+
+    table->states_num = states_after;
+    table->transitions_num = transitions_after;
+
+    if(report) {
+        report->states_before = states_before;
+        report->states_after = states_after;
+        report->bytes_before = bytes_before;
+        report->bytes_after = fsm_table_bytes(table);
+    }
+
+    partition_free(&blocks);
+    partition_free(&cords);
+    free(first);
+    free(dense);
+    free(original);
+    free(tail);
+    free(head);
+    free(old);
+    free(incoming_begin);
+    free(incoming);
+    free(renumber);
+    free(representative);
+
+    return result;
+}
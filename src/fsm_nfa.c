@@ -0,0 +1,153 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "fsm/nfa.h"
+
+static inline void set_add(fsm_nfa_set_t *set, uint16_t state) {
+    set->bits[state/64] |=(uint64_t)1<<(state%64);
+}
+
+static inline bool set_has(const fsm_nfa_set_t *set, uint16_t state) {
+    return (set->bits[state/64]>>(state%64)) & 1;
+}
+
+// word-parallel, the compiler turns it into SIMD ORs where the target has them
+static inline void set_or(fsm_nfa_set_t *dest, const fsm_nfa_set_t *src, uint16_t words) {
+    for(uint16_t w=0; w<words; w++) {
+        dest->bits[w] |=src->bits[w];
+    }
+}
+
+static inline uint16_t lowest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    uint16_t index = 0;
+
+    while(!(bits & 1)) {
+        bits >>=1;
+        index++;
+    }
+
+    return index;
+#endif
+}
+
+static uint16_t words_num(const fsm_nfa_t *nfa) {
+    return (nfa->states_num + 63)/64;
+}
+
+static void add_state(fsm_nfa_t *nfa, uint16_t state) {
+    assert(state<FSM_NFA_STATE_MAX_NUM);
+
+    if(state>=nfa->states_num) {
+        nfa->states_num = state + 1;
+    }
+}
+
+void fsm_nfa_add_transition(fsm_nfa_t *nfa, uint16_t from, uint16_t to, uint8_t event) {
+    assert(!nfa->compiled);
+    assert(event<FSM_NFA_EVENT_MAX_NUM);
+
+    add_state(nfa, from);
+    add_state(nfa, to);
+
+    if(event>=nfa->events_num) {
+        nfa->events_num = event + 1;
+    }
+
+    set_add(&nfa->delta[event][from], to);
+}
+
+void fsm_nfa_add_epsilon(fsm_nfa_t *nfa, uint16_t from, uint16_t to) {
+    assert(!nfa->compiled);
+
+    add_state(nfa, from);
+    add_state(nfa, to);
+
+    set_add(&nfa->closure[from], to);
+}
+
+void fsm_nfa_set_accepting(fsm_nfa_t *nfa, uint16_t state) {
+    add_state(nfa, state);
+
+    set_add(&nfa->accepting, state);
+}
+
+// closes epsilon edges transitively, then folds the closure of every target into delta
+void fsm_nfa_compile(fsm_nfa_t *nfa) {
+    assert(!nfa->compiled);
+
+    const uint16_t words = words_num(nfa);
+
+    for(uint16_t s=0; s<nfa->states_num; s++) {
+        set_add(&nfa->closure[s], s);
+    }
+
+    for(uint16_t k=0; k<nfa->states_num; k++) {
+        for(uint16_t s=0; s<nfa->states_num; s++) {
+            if(set_has(&nfa->closure[s], k)) {
+                set_or(&nfa->closure[s], &nfa->closure[k], words);
+            }
+        }
+    }
+
+    for(uint8_t e=0; e<nfa->events_num; e++) {
+        for(uint16_t s=0; s<nfa->states_num; s++) {
+            fsm_nfa_set_t closed = {0};
+
+            for(uint16_t w=0; w<words; w++) {
+                for(uint64_t bits=nfa->delta[e][s].bits[w]; bits; bits &=bits - 1) {
+                    set_or(&closed, &nfa->closure[w*64 + lowest_bit(bits)], words);
+                }
+            }
+
+            nfa->delta[e][s] = closed;
+        }
+    }
+
+    nfa->compiled = true;
+}
+
+void fsm_nfa_start(fsm_nfa_t *nfa, uint16_t initial) {
+    assert(nfa->compiled);
+    assert(initial<nfa->states_num);
+
+    nfa->active = nfa->closure[initial];
+}
+
+void fsm_nfa_step(const fsm_nfa_t *nfa, const fsm_nfa_set_t *from, uint8_t event, fsm_nfa_set_t *to) {
+    assert(nfa->compiled);
+
+    const uint16_t words = words_num(nfa);
+    fsm_nfa_set_t next = {0};
+
+    if(event<nfa->events_num) {
+        for(uint16_t w=0; w<words; w++) {
+            for(uint64_t bits=from->bits[w]; bits; bits &=bits - 1) {
+                set_or(&next, &nfa->delta[event][w*64 + lowest_bit(bits)], words);
+            }
+        }
+    }
+
+    *to = next;
+}
+
+void fsm_nfa_dispatch(fsm_nfa_t *nfa, uint8_t event) {
+    fsm_nfa_step(nfa, &nfa->active, event, &nfa->active);
+}
+
+bool fsm_nfa_is_active(const fsm_nfa_t *nfa, uint16_t state) {
+    return state<nfa->states_num && set_has(&nfa->active, state);
+}
+
+bool fsm_nfa_accepts(const fsm_nfa_t *nfa) {
+    for(uint16_t w=0; w<words_num(nfa); w++) {
+        if(nfa->active.bits[w] & nfa->accepting.bits[w]) {
+            return true;
+        }
+    }
+
+    return false;
+}
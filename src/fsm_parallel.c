@@ -0,0 +1,253 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "fsm/parallel.h"
+
+// paths from different start states are compared this often, merged paths are stepped once
+#define MERGE_INTERVAL  64
+
+struct log_entry {
+    const uint8_t *position;
+    uint8_t action;
+};
+
+struct chunk {
+    const fsm_stream_t *stream;
+    const uint8_t *buf;
+    size_t len;
+
+    // end row for every start state, filled by map_chunk()
+    uint16_t end[FSM_STREAM_STATE_MAX_NUM];
+
+    // actions met when run from start_row, filled by record_chunk(); recording stops at
+    // buf[recorded] in row stop_row when the log is full or cannot grow
+    uint16_t start_row;
+    struct log_entry *log;
+    size_t log_num;
+    size_t log_cap;
+    size_t recorded;
+    uint16_t stop_row;
+};
+
+// runs the chunk from every state at once, paths that reach the same row are merged
+static void * map_chunk(void *arg) {
+    struct chunk *chunk = arg;
+    const fsm_stream_t *stream = chunk->stream;
+    const struct fsm_stream_cell *cells = stream->cells;
+
+    uint16_t rows[FSM_STREAM_STATE_MAX_NUM] = {0};
+    uint8_t path[FSM_STREAM_STATE_MAX_NUM];
+    uint8_t paths_num = stream->states_num;
+
+    for(uint8_t s=0; s<stream->states_num; s++) {
+        rows[s] = s*stream->classes_num;
+        path[s] = s;
+    }
+
+    size_t i = 0;
+
+    while(i<chunk->len && paths_num>1) {
+        const size_t end = (chunk->len - i>MERGE_INTERVAL) ? i + MERGE_INTERVAL : chunk->len;
+
+        for(; i<end; i++) {
+            const uint8_t c = FSM_STREAM_COLUMN(stream, chunk->buf[i]);
+
+            for(uint8_t j=0; j<paths_num; j++) {
+                rows[j] = cells[rows[j] + c].next;
+            }
+        }
+
+        uint8_t merged[FSM_STREAM_STATE_MAX_NUM];
+        uint8_t merged_num = 0;
+
+        for(uint8_t j=0; j<paths_num; j++) {
+            uint8_t k = 0;
+
+            while(k<merged_num && rows[k]!=rows[j]) {
+                k++;
+            }
+
+            if(k==merged_num) {
+                rows[merged_num++] = rows[j];
+            }
+
+            merged[j] = k;
+        }
+
+        for(uint8_t s=0; s<stream->states_num; s++) {
+            path[s] = merged[path[s]];
+        }
+
+        paths_num = merged_num;
+    }
+
+    // single path left, plain stepping
+    uint16_t row = rows[0];
+
+    for(; i<chunk->len; i++) {
+        row = cells[row + FSM_STREAM_COLUMN(stream, chunk->buf[i])].next;
+    }
+
+    rows[0] = row;
+
+    for(uint8_t s=0; s<stream->states_num; s++) {
+        chunk->end[s] = rows[path[s]];
+    }
+
+    return NULL;
+}
+
+static void * record_chunk(void *arg) {
+    struct chunk *chunk = arg;
+    const fsm_stream_t *stream = chunk->stream;
+    const struct fsm_stream_cell *cells = stream->cells;
+
+    uint16_t row = chunk->start_row;
+    size_t i = 0;
+
+    for(; i<chunk->len; i++) {
+        const struct fsm_stream_cell cell = cells[row + FSM_STREAM_COLUMN(stream, chunk->buf[i])];
+
+        if(cell.action) {
+            if(chunk->log_num==chunk->log_cap) {
+                const size_t cap = chunk->log_cap ? 2*chunk->log_cap : 1024;
+                struct log_entry *log = NULL;
+
+                if(cap<=FSM_PARALLEL_LOG_MAX_NUM) {
+                    log = realloc(chunk->log, cap*sizeof(struct log_entry));
+                }
+
+                if(!log) {
+                    break;
+                }
+
+                chunk->log = log;
+                chunk->log_cap = cap;
+            }
+
+            chunk->log[chunk->log_num].position = &chunk->buf[i];
+            chunk->log[chunk->log_num].action = cell.action;
+            chunk->log_num++;
+        }
+
+        row = cell.next;
+    }
+
+    chunk->recorded = i;
+    chunk->stop_row = row;
+
+    return NULL;
+}
+
+// chunk 0 is fed live on the calling thread while the other chunks are mapped from every
+// start state, then the real start states are chained; with actions, chunk 1 is fed live
+// while the rest record their actions, which are replayed in order afterwards, and the part
+// of a chunk past a full log is fed serially after its recorded actions
+static void feed_piece(fsm_stream_t *stream, const uint8_t *buf, size_t len, unsigned int threads) {
+    if(threads>len/FSM_PARALLEL_CHUNK_MIN_LEN) {
+        threads = len/FSM_PARALLEL_CHUNK_MIN_LEN;
+    }
+
+    if(threads<2) {
+        fsm_feed(stream, buf, len);
+        return;
+    }
+
+    struct chunk chunks[FSM_PARALLEL_THREAD_MAX_NUM];
+    pthread_t workers[FSM_PARALLEL_THREAD_MAX_NUM];
+    bool started[FSM_PARALLEL_THREAD_MAX_NUM];
+
+    for(unsigned int k=0; k<threads; k++) {
+        const size_t begin = len/threads*k;
+        const size_t end = (k==threads - 1) ? len : len/threads*(k + 1);
+
+        chunks[k].stream = stream;
+        chunks[k].buf = &buf[begin];
+        chunks[k].len = end - begin;
+        chunks[k].log = NULL;
+        chunks[k].log_num = 0;
+        chunks[k].log_cap = 0;
+    }
+
+    // a chunk whose thread could not be created is run here once chunk 0 is done
+    for(unsigned int k=1; k<threads; k++) {
+        started[k] = !pthread_create(&workers[k], NULL, map_chunk, &chunks[k]);
+    }
+
+    fsm_feed(stream, chunks[0].buf, chunks[0].len);
+
+    for(unsigned int k=1; k<threads; k++) {
+        if(started[k]) {
+            pthread_join(workers[k], NULL);
+        } else {
+            map_chunk(&chunks[k]);
+        }
+    }
+
+    chunks[1].start_row = stream->current*stream->classes_num;
+
+    for(unsigned int k=2; k<threads; k++) {
+        chunks[k].start_row = chunks[k - 1].end[chunks[k - 1].start_row/stream->classes_num];
+    }
+
+    const uint16_t end_row = chunks[threads - 1].end[chunks[threads - 1].start_row/stream->classes_num];
+
+    if(!stream->actions_num) {
+        stream->current = end_row/stream->classes_num;
+        return;
+    }
+
+    for(unsigned int k=2; k<threads; k++) {
+        started[k] = !pthread_create(&workers[k], NULL, record_chunk, &chunks[k]);
+    }
+
+    fsm_feed(stream, chunks[1].buf, chunks[1].len);
+
+    for(unsigned int k=2; k<threads; k++) {
+        if(started[k]) {
+            pthread_join(workers[k], NULL);
+        } else {
+            record_chunk(&chunks[k]);
+        }
+    }
+
+    for(unsigned int k=2; k<threads; k++) {
+        for(size_t i=0; i<chunks[k].log_num; i++) {
+            stream->actions[chunks[k].log[i].action](stream->context, chunks[k].log[i].position);
+        }
+
+        free(chunks[k].log);
+
+        if(chunks[k].recorded<chunks[k].len) {
+            stream->current = chunks[k].stop_row/stream->classes_num;
+            fsm_feed(stream, &chunks[k].buf[chunks[k].recorded], chunks[k].len - chunks[k].recorded);
+        }
+    }
+
+    stream->current = end_row/stream->classes_num;
+}
+
+// long inputs go in pieces of at most FSM_PARALLEL_CHUNK_MAX_LEN per thread so the action logs
+// of one piece stay bounded by the chunk length
+void fsm_feed_parallel(fsm_stream_t *stream, const uint8_t *buf, size_t len, unsigned int threads) {
+    assert(stream->compiled);
+
+    if(threads>FSM_PARALLEL_THREAD_MAX_NUM) {
+        threads = FSM_PARALLEL_THREAD_MAX_NUM;
+    }
+
+    const size_t piece_max = (threads ? threads : 1)*(size_t)FSM_PARALLEL_CHUNK_MAX_LEN;
+
+    while(len) {
+        const size_t piece = (len>piece_max) ? piece_max : len;
+
+        feed_piece(stream, buf, piece, threads);
+
+        buf +=piece;
+        len -=piece;
+    }
+}
@@ -0,0 +1,405 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "fsm/pool.h"
+
+#define SLOT(handle)        ((uint32_t)(handle))
+#define GENERATION(handle)  ((uint32_t)((handle) >> 32))
+#define END                 UINT32_MAX
+#define NO_INDEX            ((fsm_index_t)~(fsm_index_t)0)
+
+// members a broadcast collects before it touches any of them
+#define BROADCAST_BATCH     32
+
+#if defined(__GNUC__)
+    #define PREFETCH(address)   __builtin_prefetch(address)
+#else
+    #define PREFETCH(address)   ((void)(address))
+#endif
+
+static fsm_handle_t make_handle(uint32_t generation, uint32_t slot) {
+    return ((fsm_handle_t)generation << 32) | slot;
+}
+
+static inline uint32_t lowest_bit(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    uint32_t index = 0;
+
+    while(!(bits & 1)) {
+        bits >>=1;
+        index++;
+    }
+
+    return index;
+#endif
+}
+
+static uint64_t * members_of(const fsm_pool_t *pool, fsm_index_t index) {
+    return &pool->members[(size_t)index*pool->words_num];
+}
+
+static void member_add(fsm_pool_t *pool, uint32_t position, fsm_index_t index) {
+    members_of(pool, index)[position/64] |=(uint64_t)1<<(position%64);
+    pool->counts[index]++;
+}
+
+static void member_remove(fsm_pool_t *pool, uint32_t position, fsm_index_t index) {
+    members_of(pool, index)[position/64] &=~((uint64_t)1<<(position%64));
+    pool->counts[index]--;
+}
+
+// first position from on that is in state index, END when there is none
+static uint32_t next_member(const fsm_pool_t *pool, fsm_index_t index, uint32_t from) {
+    const uint64_t *members = members_of(pool, index);
+    uint32_t word = from/64;
+
+    if(word>=pool->words_num) {
+        return END;
+    }
+
+    uint64_t bits = members[word] & (~(uint64_t)0<<(from%64));
+
+    while(!bits) {
+        if(++word==pool->words_num) {
+            return END;
+        }
+
+        bits = members[word];
+    }
+
+    return word*64 + lowest_bit(bits);
+}
+
+static bool update_entry(fsm_pool_t *pool, struct fsm_pool_entry *entry) {
+    const fsm_index_t index = entry->index;
+
+    if(!fsm_frozen_update(pool->frozen, &entry->index, entry->context)) {
+        return false;
+    }
+
+    if(entry->index!=index) {
+        const uint32_t position = entry - pool->entries;
+
+        member_remove(pool, position, index);
+        member_add(pool, position, entry->index);
+    }
+
+    return true;
+}
+
+// false for an id no state of the machine has
+static bool find_index(const fsm_pool_t *pool, uint8_t state, fsm_index_t *index) {
+    const fsm_index_t found = pool->lookup[state];
+
+    // the sentinel may be a valid index too, the id check tells them apart
+    if(found>=pool->frozen->states_num || pool->frozen->cold[found].id!=state) {
+        return false;
+    }
+
+    *index = found;
+
+    return true;
+}
+
+// NULL for a stale or made-up handle
+static struct fsm_pool_entry * find_entry(const fsm_pool_t *pool, fsm_handle_t handle) {
+    if(!fsm_pool_valid(pool, handle)) {
+        return NULL;
+    }
+
+    return &pool->entries[pool->positions[SLOT(handle)]];
+}
+
+void fsm_pool_init(fsm_pool_t *pool, const struct fsm_frozen *frozen, uint32_t instances_cap) {
+    assert(frozen);
+    assert(instances_cap && instances_cap<UINT32_MAX);
+
+    pool->frozen = frozen;
+    pool->entries = malloc(instances_cap*sizeof(struct fsm_pool_entry));
+    pool->positions = malloc(instances_cap*sizeof(uint32_t));
+    pool->generations = malloc(instances_cap*sizeof(uint32_t));
+    pool->words_num = (instances_cap + 63)/64;
+    pool->members = calloc((size_t)frozen->states_num*pool->words_num, sizeof(uint64_t));
+    pool->counts = calloc(frozen->states_num, sizeof(uint32_t));
+    pool->instances_num = 0;
+    pool->instances_cap = instances_cap;
+
+    assert(pool->entries);
+    assert(pool->positions);
+    assert(pool->generations);
+    assert(pool->members && pool->counts);
+
+    for(uint16_t id=0; id<256; id++) {
+        pool->lookup[id] = NO_INDEX;
+    }
+
+    for(uint16_t i=0; i<frozen->states_num; i++) {
+        pool->lookup[frozen->cold[i].id] = i;
+    }
+
+    // generation 0 is never handed out so FSM_POOL_NONE stays invalid
+    for(uint32_t i=0; i<instances_cap; i++) {
+        pool->positions[i] = i + 1;
+        pool->generations[i] = 1;
+    }
+
+    pool->free_head = 0;
+}
+
+void fsm_pool_free(fsm_pool_t *pool) {
+    free(pool->entries);
+    free(pool->positions);
+    free(pool->generations);
+    free(pool->members);
+    free(pool->counts);
+
+    pool->entries = NULL;
+    pool->positions = NULL;
+    pool->generations = NULL;
+    pool->members = NULL;
+    pool->counts = NULL;
+    pool->instances_num = 0;
+}
+
+// runs the enter callback of initial, returns FSM_POOL_NONE when the pool is full
+fsm_handle_t fsm_pool_create(fsm_pool_t *pool, void *context, uint8_t initial) {
+    if(pool->instances_num==pool->instances_cap) {
+        return FSM_POOL_NONE;
+    }
+
+    const uint32_t slot = pool->free_head;
+    struct fsm_pool_entry *entry = &pool->entries[pool->instances_num];
+
+    pool->free_head = pool->positions[slot];
+    pool->positions[slot] = pool->instances_num++;
+
+    entry->context = context;
+    entry->slot = slot;
+    entry->index = fsm_frozen_start(pool->frozen, context, initial);
+
+    member_add(pool, pool->positions[slot], entry->index);
+
+    return make_handle(pool->generations[slot], slot);
+}
+
+// no exit callback runs, returns false for a stale handle
+bool fsm_pool_destroy(fsm_pool_t *pool, fsm_handle_t handle) {
+    if(!fsm_pool_valid(pool, handle)) {
+        return false;
+    }
+
+    const uint32_t slot = SLOT(handle);
+    const uint32_t position = pool->positions[slot];
+    const uint32_t last_position = --pool->instances_num;
+    const struct fsm_pool_entry *last = &pool->entries[last_position];
+
+    member_remove(pool, position, pool->entries[position].index);
+
+    if(position!=last_position) {
+        member_remove(pool, last_position, last->index);
+        member_add(pool, position, last->index);
+
+        pool->entries[position] = *last;
+        pool->positions[last->slot] = position;
+    }
+
+    if(++pool->generations[slot]==0) {
+        pool->generations[slot] = 1;
+    }
+
+    pool->positions[slot] = pool->free_head;
+    pool->free_head = slot;
+
+    return true;
+}
+
+// a free slot keeps the generation its next handle gets and a free-list link in positions,
+// so a matching generation alone does not make a slot live, the entry has to point back at it
+bool fsm_pool_valid(const fsm_pool_t *pool, fsm_handle_t handle) {
+    const uint32_t slot = SLOT(handle);
+
+    if(slot>=pool->instances_cap || GENERATION(handle)!=pool->generations[slot]) {
+        return false;
+    }
+
+    const uint32_t position = pool->positions[slot];
+
+    return position<pool->instances_num && pool->entries[position].slot==slot;
+}
+
+// false for a stale handle as well as when no transition was taken
+bool fsm_pool_update(fsm_pool_t *pool, fsm_handle_t handle) {
+    struct fsm_pool_entry *entry = find_entry(pool, handle);
+
+    return entry && update_entry(pool, entry);
+}
+
+// false for a stale handle
+bool fsm_pool_execute(fsm_pool_t *pool, fsm_handle_t handle) {
+    const struct fsm_pool_entry *entry = find_entry(pool, handle);
+
+    if(!entry) {
+        return false;
+    }
+
+    fsm_frozen_execute(pool->frozen, entry->index, entry->context);
+
+    return true;
+}
+
+// false for a stale handle, state is left untouched then
+bool fsm_pool_state(const fsm_pool_t *pool, fsm_handle_t handle, uint8_t *state) {
+    const struct fsm_pool_entry *entry = find_entry(pool, handle);
+
+    if(!entry) {
+        return false;
+    }
+
+    *state = pool->frozen->cold[entry->index].id;
+
+    return true;
+}
+
+fsm_handle_t fsm_pool_handle(const fsm_pool_t *pool, uint32_t position) {
+    assert(position<pool->instances_num);
+
+    const uint32_t slot = pool->entries[position].slot;
+
+    return make_handle(pool->generations[slot], slot);
+}
+
+// returns the number of transitions taken
+uint32_t fsm_pool_update_all(fsm_pool_t *pool) {
+    uint32_t transitions = 0;
+
+    for(uint32_t i=0; i<pool->instances_num; i++) {
+        transitions +=update_entry(pool, &pool->entries[i]);
+    }
+
+    return transitions;
+}
+
+void fsm_pool_execute_all(fsm_pool_t *pool) {
+    for(uint32_t i=0; i<pool->instances_num; i++) {
+        fsm_frozen_execute(pool->frozen, pool->entries[i].index, pool->entries[i].context);
+    }
+}
+
+void fsm_pool_each(const fsm_pool_t *pool, fsm_pool_visit_t visit, void *arg) {
+    for(uint32_t i=0; i<pool->instances_num; i++) {
+        const struct fsm_pool_entry *entry = &pool->entries[i];
+
+        visit(fsm_pool_handle(pool, i), entry->context, pool->frozen->cold[entry->index].id, arg);
+    }
+}
+
+// 0 for an unknown state
+uint32_t fsm_pool_count(const fsm_pool_t *pool, uint8_t state) {
+    fsm_index_t index;
+
+    return find_index(pool, state, &index) ? pool->counts[index] : 0;
+}
+
+// FSM_POOL_NONE when no instance is in state or state is unknown
+fsm_handle_t fsm_pool_first(const fsm_pool_t *pool, uint8_t state) {
+    fsm_index_t index;
+
+    if(!find_index(pool, state, &index)) {
+        return FSM_POOL_NONE;
+    }
+
+    const uint32_t position = next_member(pool, index, 0);
+
+    return (position!=END) ? fsm_pool_handle(pool, position) : FSM_POOL_NONE;
+}
+
+// next instance in the same state by position, FSM_POOL_NONE after the last one and for a
+// stale handle
+fsm_handle_t fsm_pool_next(const fsm_pool_t *pool, fsm_handle_t handle) {
+    const struct fsm_pool_entry *entry = find_entry(pool, handle);
+
+    if(!entry) {
+        return FSM_POOL_NONE;
+    }
+
+    const uint32_t position = next_member(pool, entry->index, (entry - pool->entries) + 1);
+
+    return (position!=END) ? fsm_pool_handle(pool, position) : FSM_POOL_NONE;
+}
+
+void fsm_pool_each_in(const fsm_pool_t *pool, uint8_t state, fsm_pool_visit_t visit, void *arg) {
+    fsm_index_t index;
+
+    if(!find_index(pool, state, &index)) {
+        return;
+    }
+
+    for(uint32_t position=next_member(pool, index, 0); position!=END; position=next_member(pool, index, position + 1)) {
+        visit(fsm_pool_handle(pool, position), pool->entries[position].context, state, arg);
+    }
+}
+
+// copies the message to the start of the context of every instance in state, in position
+// order, then runs update and execute on it; a visited instance only ever leaves the state,
+// returns the number of instances that got it, 0 for an unknown state
+uint32_t fsm_pool_broadcast(fsm_pool_t *pool, uint8_t state, uint16_t event, void *payload) {
+    const struct fsm_message message = {
+        .event = event,
+        .payload = payload
+    };
+    uint32_t delivered = 0;
+    fsm_index_t index;
+
+    if(!find_index(pool, state, &index)) {
+        return 0;
+    }
+
+    const uint64_t *members = members_of(pool, index);
+    uint32_t batch[BROADCAST_BATCH];
+    uint32_t word = 0;
+    uint64_t bits = pool->words_num ? members[0] : 0;
+
+    // members are scattered, so their entries and then their contexts are requested a batch
+    // at a time and the misses overlap; a word is read once, the bits updates clear in it
+    // are those already visited
+    while(word<pool->words_num) {
+        uint32_t batch_num = 0;
+
+        while(batch_num<BROADCAST_BATCH) {
+            if(!bits) {
+                if(++word==pool->words_num) {
+                    break;
+                }
+
+                bits = members[word];
+                continue;
+            }
+
+            batch[batch_num] = word*64 + lowest_bit(bits);
+            PREFETCH(&pool->entries[batch[batch_num]]);
+            batch_num++;
+            bits &=bits - 1;
+        }
+
+        for(uint32_t i=0; i<batch_num; i++) {
+            PREFETCH(pool->entries[batch[i]].context);
+        }
+
+        for(uint32_t i=0; i<batch_num; i++) {
+            struct fsm_pool_entry *entry = &pool->entries[batch[i]];
+
+            assert(entry->context);
+
+            *(struct fsm_message *)entry->context = message;
+            update_entry(pool, entry);
+            fsm_frozen_execute(pool->frozen, entry->index, entry->context);
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
@@ -0,0 +1,419 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fsm/runtime.h"
+
+#define MASK    (FSM_RUNTIME_DEQUE_SIZE - 1)
+
+enum {
+    IDLE,
+    SCHEDULED,
+    RUNNING,
+    NOTIFIED
+};
+
+_Static_assert((FSM_RUNTIME_DEQUE_SIZE & MASK)==0, "FSM_RUNTIME_DEQUE_SIZE must be a power of two");
+
+// worker running on this thread, notifications from it go to its own deque
+static _Thread_local struct fsm_runtime_worker *self;
+
+static bool deque_push(struct fsm_runtime_deque *deque, uint32_t id) {
+    const int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    const int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    if(bottom - top>=FSM_RUNTIME_DEQUE_SIZE) {
+        return false;
+    }
+
+    atomic_store_explicit(&deque->buffer[bottom & MASK], id, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+    return true;
+}
+
+static uint32_t deque_take(struct fsm_runtime_deque *deque) {
+    const int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if(top>bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return FSM_RUNTIME_NONE;
+    }
+
+    uint32_t id = atomic_load_explicit(&deque->buffer[bottom & MASK], memory_order_relaxed);
+
+    // last one, race the thieves for it
+    if(top==bottom) {
+        if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            id = FSM_RUNTIME_NONE;
+        }
+
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return id;
+}
+
+static uint32_t deque_steal(struct fsm_runtime_deque *deque) {
+    int_fast64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    const int_fast64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if(top>=bottom) {
+        return FSM_RUNTIME_NONE;
+    }
+
+    const uint32_t id = atomic_load_explicit(&deque->buffer[top & MASK], memory_order_relaxed);
+
+    if(!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return FSM_RUNTIME_NONE;
+    }
+
+    return id;
+}
+
+// an instance is in at most one queue, so the injector never holds more than instances_cap
+static void inject(fsm_runtime_t *runtime, uint32_t id) {
+    pthread_mutex_lock(&runtime->injector_lock);
+
+    const uint32_t num = atomic_load_explicit(&runtime->injector_num, memory_order_relaxed);
+
+    runtime->injector[(runtime->injector_head + num)%runtime->injector_cap] = id;
+    atomic_store_explicit(&runtime->injector_num, num + 1, memory_order_relaxed);
+
+    pthread_mutex_unlock(&runtime->injector_lock);
+}
+
+// returns one instance and moves up to a batch more to the worker's deque
+static uint32_t drain_injector(struct fsm_runtime_worker *worker) {
+    fsm_runtime_t *runtime = worker->runtime;
+
+    if(!atomic_load_explicit(&runtime->injector_num, memory_order_relaxed)) {
+        return FSM_RUNTIME_NONE;
+    }
+
+    uint32_t id = FSM_RUNTIME_NONE;
+
+    pthread_mutex_lock(&runtime->injector_lock);
+
+    uint32_t num = atomic_load_explicit(&runtime->injector_num, memory_order_relaxed);
+
+    for(uint32_t taken=0; num && taken<=FSM_RUNTIME_INJECT_BATCH; taken++) {
+        const uint32_t next = runtime->injector[runtime->injector_head];
+
+        if(id!=FSM_RUNTIME_NONE && !deque_push(&worker->deque, next)) {
+            break;
+        }
+
+        if(id==FSM_RUNTIME_NONE) {
+            id = next;
+        }
+
+        runtime->injector_head = (runtime->injector_head + 1)%runtime->injector_cap;
+        num--;
+    }
+
+    atomic_store_explicit(&runtime->injector_num, num, memory_order_relaxed);
+
+    pthread_mutex_unlock(&runtime->injector_lock);
+
+    return id;
+}
+
+// sleepers are counted before they look for work a last time, so either they see the new
+// instance or it sees them
+static void wake_sleepers(fsm_runtime_t *runtime) {
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if(atomic_load_explicit(&runtime->sleepers, memory_order_relaxed)) {
+        pthread_mutex_lock(&runtime->sleep_lock);
+        runtime->epoch++;
+        pthread_cond_broadcast(&runtime->wake);
+        pthread_mutex_unlock(&runtime->sleep_lock);
+    }
+}
+
+static void schedule(fsm_runtime_t *runtime, uint32_t id) {
+    if(!self || self->runtime!=runtime || !deque_push(&self->deque, id)) {
+        inject(runtime, id);
+    }
+
+    wake_sleepers(runtime);
+}
+
+static uint32_t find_work(struct fsm_runtime_worker *worker) {
+    fsm_runtime_t *runtime = worker->runtime;
+    uint32_t id = deque_take(&worker->deque);
+
+    if(id!=FSM_RUNTIME_NONE) {
+        return id;
+    }
+
+    id = drain_injector(worker);
+
+    if(id!=FSM_RUNTIME_NONE) {
+        return id;
+    }
+
+    // every other worker once, from a random one on
+    worker->seed = worker->seed*1103515245 + 12345;
+
+    const unsigned int first = (worker->seed>>16)%runtime->workers_num;
+
+    for(unsigned int i=0; i<runtime->workers_num; i++) {
+        struct fsm_runtime_worker *victim = &runtime->workers[(first + i)%runtime->workers_num];
+
+        if(victim==worker) {
+            continue;
+        }
+
+        id = deque_steal(&victim->deque);
+
+        if(id!=FSM_RUNTIME_NONE) {
+            worker->steals++;
+            return id;
+        }
+    }
+
+    return FSM_RUNTIME_NONE;
+}
+
+static void run(struct fsm_runtime_worker *worker, uint32_t id) {
+    fsm_runtime_t *runtime = worker->runtime;
+
+    // acquires the notifications that came while the instance was queued
+    atomic_exchange_explicit(&runtime->status[id], RUNNING, memory_order_acq_rel);
+
+    if(runtime->step) {
+        runtime->step(runtime->instances[id], runtime->arg);
+    } else {
+        fsm_update(runtime->instances[id]);
+        fsm_execute(runtime->instances[id]);
+    }
+
+    worker->steps++;
+
+    uint8_t expected = RUNNING;
+
+    if(!atomic_compare_exchange_strong_explicit(&runtime->status[id], &expected, IDLE, memory_order_acq_rel, memory_order_acquire)) {
+        atomic_store_explicit(&runtime->status[id], SCHEDULED, memory_order_relaxed);
+        schedule(runtime, id);
+        return;
+    }
+
+    if(atomic_fetch_sub_explicit(&runtime->pending, 1, memory_order_acq_rel)==1) {
+        pthread_mutex_lock(&runtime->sleep_lock);
+        pthread_cond_broadcast(&runtime->idle);
+        pthread_mutex_unlock(&runtime->sleep_lock);
+    }
+}
+
+static void * worker_main(void *arg) {
+    struct fsm_runtime_worker *worker = arg;
+    fsm_runtime_t *runtime = worker->runtime;
+
+    self = worker;
+
+    while(atomic_load_explicit(&runtime->running, memory_order_relaxed)) {
+        uint32_t id = find_work(worker);
+
+        if(id!=FSM_RUNTIME_NONE) {
+            run(worker, id);
+            continue;
+        }
+
+        pthread_mutex_lock(&runtime->sleep_lock);
+        const uint32_t epoch = runtime->epoch;
+        atomic_fetch_add(&runtime->sleepers, 1);
+        pthread_mutex_unlock(&runtime->sleep_lock);
+
+        atomic_thread_fence(memory_order_seq_cst);
+
+        id = find_work(worker);
+
+        if(id!=FSM_RUNTIME_NONE) {
+            atomic_fetch_sub(&runtime->sleepers, 1);
+            run(worker, id);
+            continue;
+        }
+
+        pthread_mutex_lock(&runtime->sleep_lock);
+
+        while(runtime->epoch==epoch && atomic_load(&runtime->running)) {
+            pthread_cond_wait(&runtime->wake, &runtime->sleep_lock);
+        }
+
+        atomic_fetch_sub(&runtime->sleepers, 1);
+        pthread_mutex_unlock(&runtime->sleep_lock);
+    }
+
+    self = NULL;
+
+    return NULL;
+}
+
+// false when out of memory, nothing is left to free then
+bool fsm_runtime_init(fsm_runtime_t *runtime, uint32_t instances_cap, fsm_step_t step, void *arg) {
+    assert(instances_cap);
+
+    memset(runtime, 0, sizeof(*runtime));
+
+    runtime->instances = malloc(instances_cap*sizeof(fsm_t *));
+    runtime->status = malloc(instances_cap*sizeof(*runtime->status));
+    runtime->instances_cap = instances_cap;
+    runtime->step = step;
+    runtime->arg = arg;
+
+    runtime->injector_cap = instances_cap;
+    runtime->injector = malloc(runtime->injector_cap*sizeof(uint32_t));
+
+    if(!runtime->instances || !runtime->status || !runtime->injector) {
+        free(runtime->instances);
+        free(runtime->status);
+        free(runtime->injector);
+
+        return false;
+    }
+
+    pthread_mutex_init(&runtime->injector_lock, NULL);
+    pthread_mutex_init(&runtime->sleep_lock, NULL);
+    pthread_cond_init(&runtime->wake, NULL);
+    pthread_cond_init(&runtime->idle, NULL);
+
+    atomic_init(&runtime->injector_num, 0);
+    atomic_init(&runtime->sleepers, 0);
+    atomic_init(&runtime->pending, 0);
+    atomic_init(&runtime->running, false);
+
+    return true;
+}
+
+// returns the id to notify the instance with, the machine has to be started already
+uint32_t fsm_runtime_add(fsm_runtime_t *runtime, fsm_t *fsm) {
+    assert(runtime->instances_num<runtime->instances_cap);
+    assert(!atomic_load(&runtime->running));
+
+    const uint32_t id = runtime->instances_num++;
+
+    runtime->instances[id] = fsm;
+    atomic_init(&runtime->status[id], IDLE);
+
+    return id;
+}
+
+// wakes every sleeping worker, they leave once running is false
+static void wake_all(fsm_runtime_t *runtime) {
+    pthread_mutex_lock(&runtime->sleep_lock);
+    runtime->epoch++;
+    pthread_cond_broadcast(&runtime->wake);
+    pthread_mutex_unlock(&runtime->sleep_lock);
+}
+
+// false when the workers cannot be allocated or one of them cannot be created, the ones
+// already running are stopped and joined then and the runtime is as before the call
+bool fsm_runtime_start(fsm_runtime_t *runtime, unsigned int threads) {
+    assert(threads);
+    assert(!runtime->workers);
+
+    struct fsm_runtime_worker *workers = aligned_alloc(FSM_CACHE_LINE_SIZE, threads*sizeof(struct fsm_runtime_worker));
+
+    if(!workers) {
+        return false;
+    }
+
+    runtime->workers = workers;
+    runtime->workers_num = threads;
+
+    atomic_store(&runtime->running, true);
+
+    for(unsigned int i=0; i<threads; i++) {
+        struct fsm_runtime_worker *worker = &runtime->workers[i];
+
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+        worker->runtime = runtime;
+        worker->seed = i + 1;
+        worker->steps = 0;
+        worker->steals = 0;
+    }
+
+    for(unsigned int i=0; i<threads; i++) {
+        if(pthread_create(&workers[i].thread, NULL, worker_main, &workers[i])) {
+            atomic_store(&runtime->running, false);
+            wake_all(runtime);
+
+            for(unsigned int j=0; j<i; j++) {
+                pthread_join(workers[j].thread, NULL);
+            }
+
+            runtime->workers = NULL;
+            runtime->workers_num = 0;
+            free(workers);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// thread-safe, also from steps; an instance notified while running is stepped once more
+void fsm_runtime_notify(fsm_runtime_t *runtime, uint32_t id) {
+    assert(id<runtime->instances_num);
+
+    uint8_t status = atomic_load_explicit(&runtime->status[id], memory_order_relaxed);
+
+    // always a release write, the step that follows has to see what was written before
+    while(!atomic_compare_exchange_weak_explicit(&runtime->status[id], &status,
+        (status==IDLE) ? SCHEDULED : (status==RUNNING) ? NOTIFIED : status,
+        memory_order_acq_rel, memory_order_relaxed));
+
+    if(status==IDLE) {
+        atomic_fetch_add_explicit(&runtime->pending, 1, memory_order_relaxed);
+        schedule(runtime, id);
+    }
+}
+
+void fsm_runtime_wait_idle(fsm_runtime_t *runtime) {
+    pthread_mutex_lock(&runtime->sleep_lock);
+
+    while(atomic_load(&runtime->pending)) {
+        pthread_cond_wait(&runtime->idle, &runtime->sleep_lock);
+    }
+
+    pthread_mutex_unlock(&runtime->sleep_lock);
+}
+
+// pending instances are dropped, wait for idle first to finish them
+void fsm_runtime_stop(fsm_runtime_t *runtime) {
+    if(runtime->workers) {
+        atomic_store(&runtime->running, false);
+        wake_all(runtime);
+
+        for(unsigned int i=0; i<runtime->workers_num; i++) {
+            pthread_join(runtime->workers[i].thread, NULL);
+        }
+    }
+
+    pthread_mutex_destroy(&runtime->injector_lock);
+    pthread_mutex_destroy(&runtime->sleep_lock);
+    pthread_cond_destroy(&runtime->wake);
+    pthread_cond_destroy(&runtime->idle);
+
+    free(runtime->workers);
+    free(runtime->instances);
+    free(runtime->status);
+    free(runtime->injector);
+
+    runtime->workers = NULL;
+}
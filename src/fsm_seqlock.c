@@ -0,0 +1,71 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "fsm/seqlock.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t state_id(const fsm_t *fsm) {
+    return fsm->frozen ? fsm->frozen->cold[fsm->index].id : fsm->current->id;
+}
+
+// odd sequence while the fields change
+static void publish(fsm_seqlock_t *seqlock, uint64_t transitions) {
+    const uint32_t sequence = atomic_load_explicit(&seqlock->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&seqlock->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&seqlock->state, state_id(seqlock->fsm), memory_order_relaxed);
+    atomic_store_explicit(&seqlock->entered_ns, now_ns(), memory_order_relaxed);
+    atomic_store_explicit(&seqlock->transitions, transitions, memory_order_relaxed);
+
+    atomic_store_explicit(&seqlock->sequence, sequence + 2, memory_order_release);
+}
+
+void fsm_seqlock_init(fsm_seqlock_t *seqlock, fsm_t *fsm) {
+    seqlock->fsm = fsm;
+
+    atomic_init(&seqlock->sequence, 0);
+    atomic_init(&seqlock->state, 0);
+    atomic_init(&seqlock->entered_ns, 0);
+    atomic_init(&seqlock->transitions, 0);
+
+    publish(seqlock, 0);
+}
+
+// fsm_update() plus a publish when it took a transition, returns the same
+bool fsm_seqlock_update(fsm_seqlock_t *seqlock) {
+    if(!fsm_update(seqlock->fsm)) {
+        return false;
+    }
+
+    publish(seqlock, atomic_load_explicit(&seqlock->transitions, memory_order_relaxed) + 1);
+
+    return true;
+}
+
+void fsm_seqlock_read(const fsm_seqlock_t *seqlock, struct fsm_snapshot *snapshot) {
+    uint32_t before;
+    uint32_t after;
+
+    do {
+        before = atomic_load_explicit(&seqlock->sequence, memory_order_acquire);
+
+        snapshot->state = atomic_load_explicit(&seqlock->state, memory_order_relaxed);
+        snapshot->entered_ns = atomic_load_explicit(&seqlock->entered_ns, memory_order_relaxed);
+        snapshot->transitions = atomic_load_explicit(&seqlock->transitions, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&seqlock->sequence, memory_order_relaxed);
+    } while((before & 1) || before!=after);
+}
@@ -0,0 +1,193 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "fsm/stream.h"
+
+_Static_assert(FSM_STREAM_CLASS_MAX_NUM<=256, "FSM_STREAM_CLASS_MAX_NUM must not exceed the byte values");
+_Static_assert(FSM_STREAM_STATE_MAX_NUM<=256, "stream states are uint8_t");
+_Static_assert((FSM_STREAM_STATE_MAX_NUM - 1)*FSM_STREAM_CLASS_MAX_NUM<=UINT16_MAX, "row offsets must fit fsm_stream_cell.next");
+
+static uint8_t find_action(fsm_stream_t *stream, fsm_stream_action_t action) {
+    if(!action) {
+        return 0;
+    }
+
+    for(uint8_t i=1; i<=stream->actions_num; i++) {
+        if(stream->actions[i]==action) {
+            return i;
+        }
+    }
+
+    assert(stream->actions_num<FSM_STREAM_ACTION_MAX_NUM);
+
+    stream->actions_num++;
+    stream->actions[stream->actions_num] = action;
+
+    return stream->actions_num;
+}
+
+#ifdef FSM_STREAM_BYTE_CLASSES
+// splits byte classes until no transition range cuts through a class
+static bool build_classes(fsm_stream_t *stream) {
+    uint16_t classes[256] = {0};
+    uint16_t classes_num = 1;
+
+    for(uint16_t i=0; i<stream->transitions_num; i++) {
+        const struct fsm_stream_transition *transition = &stream->transitions[i];
+
+        uint16_t inside[256];
+        for(uint16_t c=0; c<classes_num; c++) {
+            inside[c] = UINT16_MAX;
+        }
+
+        uint16_t split_num = classes_num;
+
+        for(uint16_t b=transition->first; b<=transition->last; b++) {
+            if(inside[classes[b]]==UINT16_MAX) {
+                inside[classes[b]] = split_num++;
+            }
+
+            classes[b] = inside[classes[b]];
+        }
+
+        // renumber densely, in order of first byte
+        uint16_t dense[2*256];
+        for(uint16_t c=0; c<split_num; c++) {
+            dense[c] = UINT16_MAX;
+        }
+
+        classes_num = 0;
+
+        for(uint16_t b=0; b<256; b++) {
+            if(dense[classes[b]]==UINT16_MAX) {
+                dense[classes[b]] = classes_num++;
+            }
+
+            classes[b] = dense[classes[b]];
+        }
+    }
+
+    if(classes_num>FSM_STREAM_CLASS_MAX_NUM) {
+        return false;
+    }
+
+    for(uint16_t b=0; b<256; b++) {
+        stream->classes[b] = classes[b];
+    }
+
+    stream->classes_num = classes_num;
+
+    return true;
+}
+#endif
+
+void fsm_stream_add_transition(fsm_stream_t *stream, uint8_t from, uint8_t to, uint8_t first, uint8_t last, fsm_stream_action_t action) {
+    assert(!stream->compiled);
+    assert(stream->transitions_num<FSM_STREAM_TRANSITION_MAX_NUM);
+    assert(from<FSM_STREAM_STATE_MAX_NUM);
+    assert(to<FSM_STREAM_STATE_MAX_NUM);
+    assert(first<=last);
+
+    struct fsm_stream_transition *transition = &stream->transitions[stream->transitions_num];
+
+    transition->from = from;
+    transition->to = to;
+    transition->first = first;
+    transition->last = last;
+    transition->action = find_action(stream, action);
+    stream->transitions_num++;
+
+    if(from>=stream->states_num) {
+        stream->states_num = from + 1;
+    }
+
+    if(to>=stream->states_num) {
+        stream->states_num = to + 1;
+    }
+}
+
+// bytes without a transition keep the state, first matching transition wins like in fsm_update()
+bool fsm_stream_compile(fsm_stream_t *stream) {
+    assert(!stream->compiled);
+    assert(stream->states_num);
+
+    uint8_t representative[256];
+
+#ifdef FSM_STREAM_BYTE_CLASSES
+    if(!build_classes(stream)) {
+        return false;
+    }
+
+    for(int16_t b=255; b>=0; b--) {
+        representative[stream->classes[b]] = b;
+    }
+#else
+    stream->classes_num = 256;
+
+    for(uint16_t b=0; b<256; b++) {
+        representative[b] = b;
+    }
+#endif
+
+    for(uint8_t s=0; s<stream->states_num; s++) {
+        struct fsm_stream_cell *row = &stream->cells[s*stream->classes_num];
+
+        for(uint16_t c=0; c<stream->classes_num; c++) {
+            const uint8_t byte = representative[c];
+
+            row[c].next = s*stream->classes_num;
+            row[c].action = 0;
+
+            for(uint16_t i=0; i<stream->transitions_num; i++) {
+                const struct fsm_stream_transition *transition = &stream->transitions[i];
+
+                if(transition->from==s && byte>=transition->first && byte<=transition->last) {
+                    row[c].next = transition->to*stream->classes_num;
+                    row[c].action = transition->action;
+                    break;
+                }
+            }
+        }
+    }
+
+    stream->compiled = true;
+
+    return true;
+}
+
+void fsm_stream_start(fsm_stream_t *stream, uint8_t initial) {
+    assert(stream->compiled);
+    assert(initial<stream->states_num);
+
+    stream->current = initial;
+}
+
+void fsm_feed(fsm_stream_t *stream, const uint8_t *buf, size_t len) {
+    assert(stream->compiled);
+
+    const struct fsm_stream_cell *cells = stream->cells;
+    uint16_t row = stream->current*stream->classes_num;
+
+    if(!stream->actions_num) {
+        // pure recognizer, nothing to call
+        for(size_t i=0; i<len; i++) {
+            row = cells[row + FSM_STREAM_COLUMN(stream, buf[i])].next;
+        }
+    } else {
+        fsm_stream_action_t *actions = stream->actions;
+        void *context = stream->context;
+
+        for(size_t i=0; i<len; i++) {
+            const struct fsm_stream_cell cell = cells[row + FSM_STREAM_COLUMN(stream, buf[i])];
+
+            if(cell.action) {
+                actions[cell.action](context, &buf[i]);
+            }
+
+            row = cell.next;
+        }
+    }
+
+    stream->current = row/stream->classes_num;
+}
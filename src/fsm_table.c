@@ -0,0 +1,626 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fsm/table.h"
+
+// a row needing more attempts than this to fit moves the start of the search up to its base
+#define COMB_MAX_ATTEMPTS   4096
+
+static void * grow(void *array, size_t size, uint32_t *cap, uint32_t needed) {
+    if(needed<=*cap) {
+        return array;
+    }
+
+    uint32_t new_cap = *cap ? *cap : 16;
+
+    while(new_cap<needed) {
+        new_cap *=2;
+    }
+
+    array = realloc(array, new_cap*size);
+    assert(array);
+
+    *cap = new_cap;
+
+    return array;
+}
+
+// returns index in actions[], appending unknown ones, slots maps pointer hashes to indices
+static uint16_t intern_action(fsm_table_t *table, uint16_t *slots, uint32_t slots_num, fsm_callback_t action) {
+    if(!action) {
+        return 0;
+    }
+
+    uintptr_t key;
+    memcpy(&key, &action, sizeof(key));
+
+    uint32_t slot = (uint32_t)((key>>4)*2654435761u)%slots_num;
+
+    while(slots[slot]) {
+        if(table->actions[slots[slot]]==action) {
+            return slots[slot];
+        }
+
+        slot = (slot + 1)%slots_num;
+    }
+
+    assert(table->actions_num<UINT16_MAX);
+
+    slots[slot] = table->actions_num;
+    table->actions[table->actions_num++] = action;
+
+    return slots[slot];
+}
+
+void fsm_table_add_state(fsm_table_t *table, uint16_t id, fsm_callback_t enter, fsm_callback_t execute, fsm_callback_t exit) {
+    assert(!table->actions);
+    assert(id!=FSM_TABLE_NONE);
+
+    if(id>=table->states_num) {
+        table->states = grow(table->states, sizeof(struct fsm_table_state), &table->states_cap, id + 1);
+
+        memset(&table->states[table->states_num], 0, (id + 1 - table->states_num)*sizeof(struct fsm_table_state));
+        table->states_num = id + 1;
+    }
+
+    table->states[id].enter = enter;
+    table->states[id].execute = execute;
+    table->states[id].exit = exit;
+}
+
+void fsm_table_add_transition(fsm_table_t *table, uint16_t from, uint16_t to, uint16_t event, fsm_callback_t action) {
+    assert(!table->actions);
+    assert(from<table->states_num);
+    assert(to<table->states_num);
+    assert(event!=FSM_TABLE_NONE);
+
+    table->transitions = grow(table->transitions, sizeof(struct fsm_table_transition), &table->transitions_cap, table->transitions_num + 1);
+
+    table->transitions[table->transitions_num].from = from;
+    table->transitions[table->transitions_num].to = to;
+    table->transitions[table->transitions_num].event = event;
+    table->transitions[table->transitions_num].action = action;
+    table->transitions_num++;
+
+    if(event>=table->events_num) {
+        table->events_num = event + 1;
+    }
+}
+
+struct transition_key {
+    uint16_t from;
+    uint16_t event;
+    uint32_t index;
+};
+
+struct row_key {
+    uint32_t length;
+    uint16_t state;
+};
+
+static int compare_transitions(const void *a, const void *b) {
+    const struct transition_key *x = a;
+    const struct transition_key *y = b;
+
+    if(x->from!=y->from) {
+        return x->from<y->from ? -1 : 1;
+    }
+
+    if(x->event!=y->event) {
+        return x->event<y->event ? -1 : 1;
+    }
+
+    return x->index<y->index ? -1 : (x->index>y->index);
+}
+
+// longest rows first, they are the hardest to fit
+static int compare_rows(const void *a, const void *b) {
+    const struct row_key *x = a;
+    const struct row_key *y = b;
+
+    if(x->length!=y->length) {
+        return x->length>y->length ? -1 : 1;
+    }
+
+    return x->state<y->state ? -1 : (x->state>y->state);
+}
+
+// the first transition added for a (from, event) pair wins like in fsm_update()
+static void build_sparse(fsm_table_t *table) {
+    const uint32_t n = table->transitions_num;
+    struct transition_key *keys = malloc((n ? n : 1)*sizeof(struct transition_key));
+    assert(keys);
+
+    const uint32_t slots_num = 2*n + 1;
+    uint16_t *slots = calloc(slots_num, sizeof(uint16_t));
+    assert(slots);
+
+    for(uint32_t t=0; t<n; t++) {
+        keys[t].from = table->transitions[t].from;
+        keys[t].event = table->transitions[t].event;
+        keys[t].index = t;
+    }
+
+    qsort(keys, n, sizeof(struct transition_key), compare_transitions);
+
+    table->rows = calloc(table->states_num + 1, sizeof(uint32_t));
+    table->entries = malloc((n ? n : 1)*sizeof(struct fsm_table_entry));
+    assert(table->rows);
+    assert(table->entries);
+
+    table->entries_num = 0;
+
+    for(uint32_t i=0; i<n; i++) {
+        if(i && keys[i].from==keys[i - 1].from && keys[i].event==keys[i - 1].event) {
+            continue;
+        }
+
+        const struct fsm_table_transition *transition = &table->transitions[keys[i].index];
+        struct fsm_table_entry *entry = &table->entries[table->entries_num++];
+
+        entry->key = transition->event;
+        entry->cell.next = transition->to;
+        entry->cell.action = intern_action(table, slots, slots_num, transition->action);
+        table->rows[transition->from + 1]++;
+    }
+
+    for(uint16_t s=0; s<table->states_num; s++) {
+        table->rows[s + 1] +=table->rows[s];
+    }
+
+    free(keys);
+    free(slots);
+}
+
+static void build_dense(fsm_table_t *table) {
+    const size_t cells_num = (size_t)table->states_num*table->events_num;
+
+    table->cells = malloc((cells_num ? cells_num : 1)*sizeof(struct fsm_table_cell));
+    assert(table->cells);
+
+    for(size_t i=0; i<cells_num; i++) {
+        table->cells[i].next = FSM_TABLE_NONE;
+        table->cells[i].action = 0;
+    }
+
+    for(uint16_t s=0; s<table->states_num; s++) {
+        for(uint32_t i=table->rows[s]; i<table->rows[s + 1]; i++) {
+            table->cells[(size_t)s*table->events_num + table->entries[i].key] = table->entries[i].cell;
+        }
+    }
+
+    free(table->rows);
+    free(table->entries);
+    table->rows = NULL;
+    table->entries = NULL;
+    table->entries_num = 0;
+}
+
+// lowest free slot from index on, slots past cap are all free
+static uint32_t find_free(uint32_t *next_free, uint32_t index, uint32_t cap) {
+    uint32_t root = index;
+
+    while(root<cap && next_free[root]!=root) {
+        root = next_free[root];
+    }
+
+    while(index<cap && next_free[index]!=index) {
+        const uint32_t next = next_free[index];
+
+        next_free[index] = root;
+        index = next;
+    }
+
+    return root;
+}
+
+// first-fit row displacement over the sparse rows, slots hold their owner so rows can interleave;
+// gives up and returns false when the comb would waste more than it holds
+static bool build_comb(fsm_table_t *table, bool forced) {
+    const uint16_t states_num = table->states_num;
+    struct row_key *order = malloc(states_num*sizeof(struct row_key));
+    uint32_t *bases = malloc(states_num*sizeof(uint32_t));
+    assert(order);
+    assert(bases);
+
+    for(uint16_t s=0; s<states_num; s++) {
+        order[s].length = table->rows[s + 1] - table->rows[s];
+        order[s].state = s;
+        bases[s] = 0;
+    }
+
+    qsort(order, states_num, sizeof(struct row_key), compare_rows);
+
+    struct fsm_table_entry *slots = NULL;
+    uint32_t *next_free = NULL;
+    uint32_t slots_cap = 0;
+    uint32_t slots_num = 0;
+    uint32_t floor = 0;
+
+    for(uint16_t i=0; i<states_num && order[i].length; i++) {
+        const struct fsm_table_entry *row = &table->entries[table->rows[order[i].state]];
+        const uint32_t length = order[i].length;
+        uint32_t attempts = 0;
+        uint32_t first = find_free(next_free, floor + row[0].key, slots_cap);
+        uint32_t base;
+
+        // bases that put the first event on a free slot
+        for(;; first=find_free(next_free, first + 1, slots_cap)) {
+            base = first - row[0].key;
+            attempts++;
+
+            const uint32_t needed = base + table->events_num + 1;
+
+            if(needed>slots_cap) {
+                uint32_t cap = slots_cap;
+
+                slots = grow(slots, sizeof(struct fsm_table_entry), &cap, needed);
+                next_free = realloc(next_free, cap*sizeof(uint32_t));
+                assert(next_free);
+
+                for(uint32_t k=slots_cap; k<cap; k++) {
+                    slots[k].key = FSM_TABLE_NONE;
+                    next_free[k] = k;
+                }
+
+                slots_cap = cap;
+            }
+
+            uint32_t k = 1;
+
+            while(k<length && slots[base + row[k].key].key==FSM_TABLE_NONE) {
+                k++;
+            }
+
+            if(k==length && slots[base + row[0].key].key==FSM_TABLE_NONE) {
+                break;
+            }
+        }
+
+        for(uint32_t k=0; k<length; k++) {
+            slots[base + row[k].key].key = order[i].state;
+            slots[base + row[k].key].cell = row[k].cell;
+            next_free[base + row[k].key] = base + row[k].key + 1;
+        }
+
+        bases[order[i].state] = base;
+
+        // the comb is nearly full below base, later rows skip that part
+        if(attempts>COMB_MAX_ATTEMPTS) {
+            floor = base;
+        }
+
+        if(base + row[length - 1].key + 1>slots_num) {
+            slots_num = base + row[length - 1].key + 1;
+        }
+    }
+
+    free(next_free);
+    free(order);
+
+    if(!forced && slots_num>2*table->entries_num) {
+        free(slots);
+        free(bases);
+        return false;
+    }
+
+    free(table->rows);
+    free(table->entries);
+    table->rows = bases;
+    table->entries = slots;
+    table->entries_num = slots_num;
+
+    return true;
+}
+
+static inline uint32_t mix(uint32_t x) {
+    x ^=x>>16;
+    x *=0x85ebca6b;
+    x ^=x>>13;
+    x *=0xc2b2ae35;
+    x ^=x>>16;
+
+    return x;
+}
+
+// maps a hash onto 0..n-1 without a division
+static inline uint32_t reduce(uint32_t hash, uint32_t n) {
+    return (uint32_t)(((uint64_t)hash*n)>>32);
+}
+
+static inline uint32_t hash_key(uint16_t state, uint16_t event) {
+    return (uint32_t)state<<16 | event;
+}
+
+// hash and displace: keys go to buckets of ~4, the biggest buckets first get the first seed that
+// sends all their keys to free slots, the last ones fill the table up to exactly n slots
+static void build_hash(fsm_table_t *table) {
+    const uint32_t n = table->entries_num;
+    const uint32_t buckets_num = n/4 + 1;
+
+    uint32_t *begin = calloc(buckets_num + 1, sizeof(uint32_t));
+    uint32_t *members = malloc((n ? n : 1)*sizeof(uint32_t));
+    uint32_t *keys = malloc((n ? n : 1)*sizeof(uint32_t));
+    uint32_t *seeds = calloc(buckets_num, sizeof(uint32_t));
+    bool *taken = calloc(n ? n : 1, sizeof(bool));
+    uint16_t *owners = malloc((n ? n : 1)*sizeof(uint16_t));
+    struct fsm_table_slot *slots = malloc((n ? n : 1)*sizeof(struct fsm_table_slot));
+    assert(begin && members && keys && seeds && taken && owners && slots);
+
+    for(uint16_t s=0; s<table->states_num; s++) {
+        for(uint32_t i=table->rows[s]; i<table->rows[s + 1]; i++) {
+            keys[i] = hash_key(s, table->entries[i].key);
+            owners[i] = s;
+            begin[reduce(mix(keys[i]), buckets_num) + 1]++;
+        }
+    }
+
+    uint32_t largest = 0;
+
+    for(uint32_t b=0; b<buckets_num; b++) {
+        if(begin[b + 1]>largest) {
+            largest = begin[b + 1];
+        }
+
+        begin[b + 1] +=begin[b];
+    }
+
+    for(uint32_t i=0; i<n; i++) {
+        members[begin[reduce(mix(keys[i]), buckets_num)]++] = i;
+    }
+
+    for(uint32_t b=buckets_num; b>0; b--) {
+        begin[b] = begin[b - 1];
+    }
+
+    begin[0] = 0;
+
+    uint32_t *positions = malloc((largest ? largest : 1)*sizeof(uint32_t));
+    assert(positions);
+
+    if(!n) {
+        slots[0].state = FSM_TABLE_NONE;
+    }
+
+    for(uint32_t size=largest; size>0; size--) {
+        for(uint32_t b=0; b<buckets_num; b++) {
+            if(begin[b + 1] - begin[b]!=size) {
+                continue;
+            }
+
+            for(uint32_t displacement=0;; displacement++) {
+                const uint32_t seed = mix(displacement + 0x9e3779b9);
+                uint32_t k = 0;
+
+                for(; k<size; k++) {
+                    const uint32_t position = reduce(mix(keys[members[begin[b] + k]] ^ seed), n);
+                    uint32_t j = 0;
+
+                    while(j<k && positions[j]!=position) {
+                        j++;
+                    }
+
+                    if(taken[position] || j<k) {
+                        break;
+                    }
+
+                    positions[k] = position;
+                }
+
+                if(k==size) {
+                    seeds[b] = seed;
+                    break;
+                }
+            }
+
+            for(uint32_t k=0; k<size; k++) {
+                taken[positions[k]] = true;
+            }
+        }
+    }
+
+    for(uint32_t i=0; i<n; i++) {
+        const uint32_t b = reduce(mix(keys[i]), buckets_num);
+        struct fsm_table_slot *slot = &slots[reduce(mix(keys[i] ^ seeds[b]), n)];
+
+        slot->state = owners[i];
+        slot->event = table->entries[i].key;
+        slot->cell = table->entries[i].cell;
+    }
+
+    free(begin);
+    free(members);
+    free(keys);
+    free(taken);
+    free(positions);
+    free(owners);
+    free(table->rows);
+    free(table->entries);
+
+    table->rows = seeds;
+    table->entries = NULL;
+    table->slots = slots;
+    table->buckets_num = buckets_num;
+}
+
+// dense while its cells fit in FSM_TABLE_DENSE_MAX_BYTES or the table is at least
+// FSM_TABLE_DENSE_MIN_PERCENT full, else comb unless it packs badly, then sparse rows when
+// they are short enough to search and a perfect hash when not
+void fsm_table_build(fsm_table_t *table) {
+    fsm_table_build_layout(table, FSM_TABLE_AUTO);
+}
+
+void fsm_table_build_layout(fsm_table_t *table, enum fsm_table_layout layout) {
+    assert(!table->actions);
+    assert(table->states_num);
+
+    table->actions = malloc((table->transitions_num + 1)*sizeof(fsm_callback_t));
+    assert(table->actions);
+    table->actions[0] = NULL;
+    table->actions_num = 1;
+
+    build_sparse(table);
+
+    if(layout==FSM_TABLE_AUTO) {
+        const uint64_t cells_num = (uint64_t)table->states_num*table->events_num;
+        const bool small = cells_num*sizeof(struct fsm_table_cell)<=FSM_TABLE_DENSE_MAX_BYTES;
+        const bool full = (uint64_t)table->entries_num*100>=cells_num*FSM_TABLE_DENSE_MIN_PERCENT;
+
+        layout = (small || full) ? FSM_TABLE_DENSE : FSM_TABLE_COMB;
+
+        if(layout==FSM_TABLE_COMB && !build_comb(table, false)) {
+            layout = (table->entries_num>(uint32_t)table->states_num*FSM_TABLE_SPARSE_MAX_ROW) ? FSM_TABLE_HASH : FSM_TABLE_SPARSE;
+        }
+    } else if(layout==FSM_TABLE_COMB) {
+        build_comb(table, true);
+    }
+
+    if(layout==FSM_TABLE_HASH) {
+        build_hash(table);
+    }
+
+    if(layout==FSM_TABLE_DENSE) {
+        build_dense(table);
+    }
+
+    table->layout = layout;
+}
+
+// memory used by the dispatch structure, builder arrays excluded, counted as dense until built
+size_t fsm_table_bytes(const fsm_table_t *table) {
+    size_t bytes = table->states_num*sizeof(struct fsm_table_state) + table->actions_num*sizeof(fsm_callback_t);
+
+    switch(table->layout) {
+    case FSM_TABLE_SPARSE:
+        return bytes + (table->states_num + 1)*sizeof(uint32_t) + table->entries_num*sizeof(struct fsm_table_entry);
+    case FSM_TABLE_COMB:
+        return bytes + table->states_num*sizeof(uint32_t) + table->entries_num*sizeof(struct fsm_table_entry);
+    case FSM_TABLE_HASH:
+        return bytes + table->buckets_num*sizeof(uint32_t) + (table->entries_num ? table->entries_num : 1)*sizeof(struct fsm_table_slot);
+    default:
+        return bytes + (size_t)table->states_num*table->events_num*sizeof(struct fsm_table_cell);
+    }
+}
+
+void fsm_table_free(fsm_table_t *table) {
+    free(table->states);
+    free(table->transitions);
+    free(table->actions);
+    free(table->cells);
+    free(table->rows);
+    free(table->entries);
+    free(table->slots);
+
+    void *context = table->context;
+
+    memset(table, 0, sizeof(*table));
+    table->context = context;
+}
+
+void fsm_table_start(fsm_table_t *table, uint16_t initial) {
+    assert(table->actions);
+    assert(initial<table->states_num);
+
+    table->current = initial;
+
+    if(table->states[initial].enter) {
+        table->states[initial].enter(table->context);
+    }
+}
+
+static inline const struct fsm_table_cell * find(const fsm_table_t *table, uint16_t event) {
+    const uint16_t state = table->current;
+
+    switch(table->layout) {
+    case FSM_TABLE_DENSE:
+        if(event<table->events_num) {
+            const struct fsm_table_cell *cell = &table->cells[(size_t)state*table->events_num + event];
+
+            if(cell->next!=FSM_TABLE_NONE) {
+                return cell;
+            }
+        }
+        break;
+    case FSM_TABLE_SPARSE: {
+        uint32_t low = table->rows[state];
+        uint32_t high = table->rows[state + 1];
+
+        while(low<high) {
+            const uint32_t middle = low + (high - low)/2;
+
+            if(table->entries[middle].key<event) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        if(low<table->rows[state + 1] && table->entries[low].key==event) {
+            return &table->entries[low].cell;
+        }
+        break;
+    }
+    case FSM_TABLE_COMB: {
+        const uint32_t slot = table->rows[state] + event;
+
+        if(slot<table->entries_num && table->entries[slot].key==state) {
+            return &table->entries[slot].cell;
+        }
+        break;
+    }
+    case FSM_TABLE_HASH: {
+        const uint32_t key = hash_key(state, event);
+        const uint32_t seed = table->rows[reduce(mix(key), table->buckets_num)];
+        const struct fsm_table_slot *slot = &table->slots[reduce(mix(key ^ seed), table->entries_num)];
+
+        if(slot->state==state && slot->event==event) {
+            return &slot->cell;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return NULL;
+}
+
+// returns true when the event caused a transition
+bool fsm_table_dispatch(fsm_table_t *table, uint16_t event) {
+    assert(table->actions);
+
+    const struct fsm_table_cell *found = find(table, event);
+
+    if(!found) {
+        return false;
+    }
+
+    const struct fsm_table_cell cell = *found;
+
+    if(table->states[table->current].exit) {
+        table->states[table->current].exit(table->context);
+    }
+
+    if(cell.action) {
+        table->actions[cell.action](table->context);
+    }
+
+    table->current = cell.next;
+
+    if(table->states[cell.next].enter) {
+        table->states[cell.next].enter(table->context);
+    }
+
+    return true;
+}
+
+void fsm_table_execute(fsm_table_t *table) {
+    assert(table->actions);
+
+    if(table->states[table->current].execute) {
+        table->states[table->current].execute(table->context);
+    }
+}
@@ -0,0 +1,231 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "fsm/threaded.h"
+
+// every state compiles to a block of trigger checks ending in IDLE, followed by
+// one block per transition: exit, action, SET current, enter, NEXT state block
+enum {
+    FSM_THREADED_OP_TRIGGER,    // trigger, target pc
+    FSM_THREADED_OP_TAKE,       // target pc
+    FSM_THREADED_OP_IDLE,
+    FSM_THREADED_OP_CALL,       // callback
+    FSM_THREADED_OP_SET,        // state index
+    FSM_THREADED_OP_NEXT,       // state entry pc
+    FSM_THREADED_OP_NUM
+};
+
+// with table non-NULL only stores the label table used to encode opcodes there, threaded is
+// not touched then
+static uint16_t interpret(fsm_threaded_t *threaded, uint16_t max_steps, const void *const **table) {
+#ifdef FSM_THREADED_COMPUTED_GOTO
+    static const void *const labels[FSM_THREADED_OP_NUM] = {
+        [FSM_THREADED_OP_TRIGGER] = __extension__ &&op_FSM_THREADED_OP_TRIGGER,
+        [FSM_THREADED_OP_TAKE] = __extension__ &&op_FSM_THREADED_OP_TAKE,
+        [FSM_THREADED_OP_IDLE] = __extension__ &&op_FSM_THREADED_OP_IDLE,
+        [FSM_THREADED_OP_CALL] = __extension__ &&op_FSM_THREADED_OP_CALL,
+        [FSM_THREADED_OP_SET] = __extension__ &&op_FSM_THREADED_OP_SET,
+        [FSM_THREADED_OP_NEXT] = __extension__ &&op_FSM_THREADED_OP_NEXT,
+    };
+
+    #define OP(name)    op_##name
+    // -Wpedantic stays on for the rest of the file, only the GNU goto is exempt
+    #define DISPATCH()  _Pragma("GCC diagnostic push") \
+                        _Pragma("GCC diagnostic ignored \"-Wpedantic\"") \
+                        goto *(pc++)->label; \
+                        _Pragma("GCC diagnostic pop")
+#else
+    #define OP(name)    case name
+    #define DISPATCH()  goto dispatch
+#endif
+
+    if(table) {
+#ifdef FSM_THREADED_COMPUTED_GOTO
+        *table = labels;
+#else
+        *table = NULL;
+#endif
+        return 0;
+    }
+
+    fsm_t *fsm = threaded->fsm;
+    void *context = fsm->context;
+    const union fsm_threaded_cell *program = threaded->program;
+    const union fsm_threaded_cell *pc = &program[threaded->entry[fsm->current - fsm->states]];
+    uint16_t taken = 0;
+
+#ifdef FSM_THREADED_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch((pc++)->op) {
+#endif
+
+    OP(FSM_THREADED_OP_TRIGGER): {
+        const fsm_trigger_t trigger = pc[0].trigger;
+        const uint16_t target = pc[1].pc;
+
+        pc +=2;
+
+        if(trigger(context)) {
+            pc = &program[target];
+        }
+
+        DISPATCH();
+    }
+
+    OP(FSM_THREADED_OP_TAKE): {
+        pc = &program[pc[0].pc];
+        DISPATCH();
+    }
+
+    OP(FSM_THREADED_OP_IDLE): {
+        return taken;
+    }
+
+    OP(FSM_THREADED_OP_CALL): {
+        pc[0].callback(context);
+        pc++;
+        DISPATCH();
+    }
+
+    OP(FSM_THREADED_OP_SET): {
+        fsm->current = &fsm->states[pc[0].pc];
+        pc++;
+        taken++;
+        DISPATCH();
+    }
+
+    OP(FSM_THREADED_OP_NEXT): {
+        if(taken>=max_steps) {
+            return taken;
+        }
+
+        pc = &program[pc[0].pc];
+        DISPATCH();
+    }
+
+#ifndef FSM_THREADED_COMPUTED_GOTO
+    }
+
+    assert(false);
+    return taken;
+#endif
+
+    #undef OP
+    #undef DISPATCH
+}
+
+static void emit_op(fsm_threaded_t *threaded, const void *const *labels, uintptr_t op) {
+    assert(threaded->program_size<FSM_THREADED_PROGRAM_SIZE);
+
+    if(labels) {
+        threaded->program[threaded->program_size++].label = labels[op];
+    } else {
+        threaded->program[threaded->program_size++].op = op;
+    }
+}
+
+static void emit_pc(fsm_threaded_t *threaded, uint16_t pc) {
+    assert(threaded->program_size<FSM_THREADED_PROGRAM_SIZE);
+
+    threaded->program[threaded->program_size++].pc = pc;
+}
+
+static void emit_call(fsm_threaded_t *threaded, const void *const *labels, fsm_callback_t callback) {
+    if(callback) {
+        emit_op(threaded, labels, FSM_THREADED_OP_CALL);
+
+        assert(threaded->program_size<FSM_THREADED_PROGRAM_SIZE);
+        threaded->program[threaded->program_size++].callback = callback;
+    }
+}
+
+static uint16_t transition_size(const struct fsm_state *from, const struct fsm_event *event) {
+    return (from->exit ? 2 : 0) + (event->action ? 2 : 0) + 2 + (event->next->enter ? 2 : 0) + 2;
+}
+
+void fsm_threaded_compile(fsm_threaded_t *threaded, fsm_t *fsm) {
+    assert(!fsm->frozen);
+
+    const void *const *labels;
+    interpret(NULL, 0, &labels);
+
+    threaded->fsm = fsm;
+    threaded->program_size = 0;
+
+    // first pass only places the state blocks
+    uint16_t pc = 0;
+
+    for(uint8_t i=0; i<fsm->states_num; i++) {
+        const struct fsm_state *state = &fsm->states[i];
+
+        threaded->entry[i] = pc;
+
+        for(uint8_t j=0; j<state->events_num; j++) {
+            pc +=(state->events[j].trigger ? 3 : 2) + transition_size(state, &state->events[j]);
+        }
+
+        pc++;
+    }
+
+    assert(pc<=FSM_THREADED_PROGRAM_SIZE);
+
+    for(uint8_t i=0; i<fsm->states_num; i++) {
+        const struct fsm_state *state = &fsm->states[i];
+
+        uint16_t target = threaded->entry[i] + 1;
+
+        for(uint8_t j=0; j<state->events_num; j++) {
+            target +=state->events[j].trigger ? 3 : 2;
+        }
+
+        for(uint8_t j=0; j<state->events_num; j++) {
+            if(state->events[j].trigger) {
+                emit_op(threaded, labels, FSM_THREADED_OP_TRIGGER);
+
+                assert(threaded->program_size<FSM_THREADED_PROGRAM_SIZE);
+                threaded->program[threaded->program_size++].trigger = state->events[j].trigger;
+            } else {
+                emit_op(threaded, labels, FSM_THREADED_OP_TAKE);
+            }
+
+            emit_pc(threaded, target);
+            target +=transition_size(state, &state->events[j]);
+        }
+
+        emit_op(threaded, labels, FSM_THREADED_OP_IDLE);
+
+        for(uint8_t j=0; j<state->events_num; j++) {
+            const struct fsm_event *event = &state->events[j];
+            const uint8_t next = event->next - fsm->states;
+
+            emit_call(threaded, labels, state->exit);
+            emit_call(threaded, labels, event->action);
+            emit_op(threaded, labels, FSM_THREADED_OP_SET);
+            emit_pc(threaded, next);
+            emit_call(threaded, labels, event->next->enter);
+            emit_op(threaded, labels, FSM_THREADED_OP_NEXT);
+            emit_pc(threaded, threaded->entry[next]);
+        }
+    }
+
+    assert(threaded->program_size==pc);
+}
+
+// takes transitions until no trigger fires or max_steps were taken, returns how many were taken
+uint16_t fsm_threaded_run(fsm_threaded_t *threaded, uint16_t max_steps) {
+    assert(threaded->fsm->current);
+
+    if(!max_steps) {
+        return 0;
+    }
+
+    return interpret(threaded, max_steps, NULL);
+}
+
+// same as fsm_update()
+bool fsm_threaded_update(fsm_threaded_t *threaded) {
+    return fsm_threaded_run(threaded, 1)>0;
+}
@@ -0,0 +1,167 @@
+#define _GNU_SOURCE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include "fsm/wait.h"
+
+#ifdef FSM_WAIT_FUTEX
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#else
+    #include <pthread.h>
+
+    // parking lot shared by all machines, a wake-up goes to every waiter of the bucket
+    #define BUCKETS_NUM 64
+
+    static struct {
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+    } buckets[BUCKETS_NUM];
+
+    static pthread_once_t buckets_once = PTHREAD_ONCE_INIT;
+
+    static void buckets_init(void) {
+        pthread_condattr_t attributes;
+
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+
+        for(int i=0; i<BUCKETS_NUM; i++) {
+            pthread_mutex_init(&buckets[i].lock, NULL);
+            pthread_cond_init(&buckets[i].changed, &attributes);
+        }
+
+        pthread_condattr_destroy(&attributes);
+    }
+
+    static unsigned int bucket_of(const fsm_atomic_t *atomic) {
+        return ((uintptr_t)atomic/sizeof(fsm_atomic_t))%BUCKETS_NUM;
+    }
+#endif
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec*1000 + (uint64_t)ts.tv_nsec/1000000;
+}
+
+static uint8_t state_id(const fsm_atomic_t *atomic, uint32_t current) {
+    const fsm_t *fsm = atomic->fsm;
+    const uint16_t index = FSM_ATOMIC_INDEX(current);
+
+    return fsm->frozen ? fsm->frozen->cold[index].id : fsm->states[index].id;
+}
+
+// a transition counts once its enter callback returned, until then the old state holds
+static bool reached(const fsm_atomic_t *atomic, uint32_t current, uint8_t id, bool equal) {
+    return !(current & FSM_ATOMIC_COMMITTING) && (state_id(atomic, current)==id)==equal;
+}
+
+// sleeps while current still holds seen, at most timeout_ms, wakes up spuriously at times
+static void sleep_on(fsm_atomic_t *atomic, uint32_t seen, int32_t timeout_ms) {
+#ifdef FSM_WAIT_FUTEX
+    struct timespec timeout = {timeout_ms/1000, (timeout_ms%1000)*1000000L};
+
+    syscall(SYS_futex, (uint32_t *)&atomic->current, FUTEX_WAIT_PRIVATE, seen, (timeout_ms<0) ? NULL : &timeout, NULL, 0);
+#else
+    const unsigned int bucket = bucket_of(atomic);
+
+    pthread_mutex_lock(&buckets[bucket].lock);
+
+    if(atomic_load(&atomic->current)==seen) {
+        if(timeout_ms<0) {
+            pthread_cond_wait(&buckets[bucket].changed, &buckets[bucket].lock);
+        } else {
+            struct timespec deadline;
+
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec +=timeout_ms/1000;
+            deadline.tv_nsec +=(timeout_ms%1000)*1000000L;
+
+            if(deadline.tv_nsec>=1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -=1000000000L;
+            }
+
+            pthread_cond_timedwait(&buckets[bucket].changed, &buckets[bucket].lock, &deadline);
+        }
+    }
+
+    pthread_mutex_unlock(&buckets[bucket].lock);
+#endif
+}
+
+// waits until the current state is id, or is not id when equal is false
+static bool wait_until(fsm_atomic_t *atomic, uint8_t id, bool equal, int32_t timeout_ms) {
+    const uint64_t deadline = now_ms() + ((timeout_ms<0) ? 0 : (uint64_t)timeout_ms);
+    uint32_t current = atomic_load(&atomic->current);
+
+    if(reached(atomic, current, id, equal)) {
+        return true;
+    }
+
+#ifndef FSM_WAIT_FUTEX
+    pthread_once(&buckets_once, buckets_init);
+#endif
+
+    // counted before current is read again, a commit either sees the waiter or is seen by it
+    atomic_fetch_add(&atomic->waiters, 1);
+
+    bool done = false;
+
+    for(;;) {
+        current = atomic_load(&atomic->current);
+
+        if(reached(atomic, current, id, equal)) {
+            done = true;
+            break;
+        }
+
+        int32_t remaining = FSM_WAIT_INFINITE;
+
+        if(timeout_ms>=0) {
+            const uint64_t now = now_ms();
+
+            if(now>=deadline) {
+                break;
+            }
+
+            remaining = (int32_t)(deadline - now);
+        }
+
+        sleep_on(atomic, current, remaining);
+    }
+
+    atomic_fetch_sub(&atomic->waiters, 1);
+
+    return done;
+}
+
+bool fsm_wait_state(fsm_atomic_t *atomic, uint8_t id, int32_t timeout_ms) {
+    return wait_until(atomic, id, true, timeout_ms);
+}
+
+// returns once the machine is in a state other than old
+bool fsm_wait_change(fsm_atomic_t *atomic, uint8_t old, int32_t timeout_ms) {
+    return wait_until(atomic, old, false, timeout_ms);
+}
+
+void fsm_wait_wake(fsm_atomic_t *atomic) {
+#ifdef FSM_WAIT_FUTEX
+    syscall(SYS_futex, (uint32_t *)&atomic->current, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    const unsigned int bucket = bucket_of(atomic);
+
+    pthread_mutex_lock(&buckets[bucket].lock);
+    pthread_cond_broadcast(&buckets[bucket].changed);
+    pthread_mutex_unlock(&buckets[bucket].lock);
+#endif
+}
@@ -0,0 +1,383 @@
+// fsmc - generates a switch-based C implementation of a machine description
+//
+// usage: fsmc <description> <output.c> <output.h>
+//
+// description, one declaration per line, '#' starts a comment:
+//   machine <name>
+//   state <name> [enter=<fn>] [execute=<fn>] [exit=<fn>]
+//   transition <from> <to> [trigger=<fn>] [action=<fn>]
+//
+// states are numbered in declaration order, transitions of a state are
+// checked in declaration order like in fsm_update(), a function is either
+// a trigger or a state/action callback, never both, lines are at most
+// FSMC_LINE_MAX_LEN - 2 characters
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define FSMC_NAME_MAX_LEN           64
+#define FSMC_STATE_MAX_NUM          256
+#define FSMC_TRANSITION_MAX_NUM     4096
+#define FSMC_LINE_MAX_LEN           512
+
+struct fsmc_state {
+    char name[FSMC_NAME_MAX_LEN];
+    char enter[FSMC_NAME_MAX_LEN];
+    char execute[FSMC_NAME_MAX_LEN];
+    char exit[FSMC_NAME_MAX_LEN];
+};
+
+struct fsmc_transition {
+    int from;
+    int to;
+    char trigger[FSMC_NAME_MAX_LEN];
+    char action[FSMC_NAME_MAX_LEN];
+};
+
+struct fsmc_callback {
+    const char *name;
+    bool trigger;
+};
+
+static char machine[FSMC_NAME_MAX_LEN];
+static struct fsmc_state states[FSMC_STATE_MAX_NUM];
+static int states_num;
+static struct fsmc_transition transitions[FSMC_TRANSITION_MAX_NUM];
+static int transitions_num;
+static struct fsmc_callback callbacks[3*FSMC_STATE_MAX_NUM + 2*FSMC_TRANSITION_MAX_NUM];
+static int callbacks_num;
+
+static const char *path;
+static int line_num;
+
+static void fail(const char *message, const char *detail) {
+    fprintf(stderr, "%s:%d: %s '%s'\n", path, line_num, message, detail);
+    exit(1);
+}
+
+static void copy_identifier(char *dest, const char *src) {
+    if(!isalpha((unsigned char)src[0]) && src[0]!='_') {
+        fail("invalid identifier", src);
+    }
+
+    for(const char *c=src; *c; c++) {
+        if(!isalnum((unsigned char)*c) && *c!='_') {
+            fail("invalid identifier", src);
+        }
+    }
+
+    if(strlen(src)>=FSMC_NAME_MAX_LEN) {
+        fail("identifier too long", src);
+    }
+
+    strcpy(dest, src);
+}
+
+// -1 when no state has that name
+static int lookup_state(const char *name) {
+    for(int i=0; i<states_num; i++) {
+        if(!strcmp(states[i].name, name)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int find_state(const char *name) {
+    const int state = lookup_state(name);
+
+    if(state<0) {
+        fail("unknown state", name);
+    }
+
+    return state;
+}
+
+// key=value attribute, value is copied into the field named by key
+static void parse_attribute(char *token, const char **keys, char **fields, int num) {
+    char *value = strchr(token, '=');
+
+    if(!value) {
+        fail("expected key=value", token);
+    }
+
+    *value++ = '\0';
+
+    for(int i=0; i<num; i++) {
+        if(!strcmp(token, keys[i])) {
+            copy_identifier(fields[i], value);
+            return;
+        }
+    }
+
+    fail("unknown attribute", token);
+}
+
+// the first use of a function fixes its signature, a later use with the other one is an error
+static void use_callback(const char *name, bool trigger) {
+    if(!name[0]) {
+        return;
+    }
+
+    for(int i=0; i<callbacks_num; i++) {
+        if(!strcmp(callbacks[i].name, name)) {
+            if(callbacks[i].trigger!=trigger) {
+                fail("used both as trigger and callback", name);
+            }
+
+            return;
+        }
+    }
+
+    callbacks[callbacks_num].name = name;
+    callbacks[callbacks_num].trigger = trigger;
+    callbacks_num++;
+}
+
+static void parse(FILE *file) {
+    char line[FSMC_LINE_MAX_LEN];
+
+    while(fgets(line, sizeof(line), file)) {
+        line_num++;
+
+        // fgets() would hand the rest of the line back as a line of its own
+        if(!strchr(line, '\n') && getc(file)!=EOF) {
+            line[32] = '\0';
+            fail("line too long", line);
+        }
+
+        char *comment = strchr(line, '#');
+        if(comment) {
+            *comment = '\0';
+        }
+
+        const char *delimiters = " \t\r\n";
+        char *keyword = strtok(line, delimiters);
+
+        if(!keyword) {
+            continue;
+        }
+
+        if(!strcmp(keyword, "machine")) {
+            char *name = strtok(NULL, delimiters);
+
+            if(!name) {
+                fail("missing name after", keyword);
+            }
+
+            copy_identifier(machine, name);
+        } else if(!strcmp(keyword, "state")) {
+            char *name = strtok(NULL, delimiters);
+
+            if(!name) {
+                fail("missing name after", keyword);
+            }
+
+            if(states_num==FSMC_STATE_MAX_NUM) {
+                fail("too many states at", name);
+            }
+
+            if(lookup_state(name)>=0) {
+                fail("duplicate state", name);
+            }
+
+            struct fsmc_state *state = &states[states_num++];
+            copy_identifier(state->name, name);
+
+            const char *keys[] = {"enter", "execute", "exit"};
+            char *fields[] = {state->enter, state->execute, state->exit};
+
+            for(char *token=strtok(NULL, delimiters); token; token=strtok(NULL, delimiters)) {
+                parse_attribute(token, keys, fields, 3);
+            }
+
+            use_callback(state->enter, false);
+            use_callback(state->execute, false);
+            use_callback(state->exit, false);
+        } else if(!strcmp(keyword, "transition")) {
+            char *from = strtok(NULL, delimiters);
+            char *to = strtok(NULL, delimiters);
+
+            if(!from || !to) {
+                fail("missing states after", keyword);
+            }
+
+            if(transitions_num==FSMC_TRANSITION_MAX_NUM) {
+                fail("too many transitions at", from);
+            }
+
+            struct fsmc_transition *transition = &transitions[transitions_num++];
+            transition->from = find_state(from);
+            transition->to = find_state(to);
+
+            const char *keys[] = {"trigger", "action"};
+            char *fields[] = {transition->trigger, transition->action};
+
+            for(char *token=strtok(NULL, delimiters); token; token=strtok(NULL, delimiters)) {
+                parse_attribute(token, keys, fields, 2);
+            }
+
+            use_callback(transition->trigger, true);
+            use_callback(transition->action, false);
+        } else {
+            fail("unknown keyword", keyword);
+        }
+    }
+
+    if(!machine[0]) {
+        fail("missing", "machine");
+    }
+
+    if(!states_num) {
+        fail("no states in machine", machine);
+    }
+}
+
+static void upper(char *dest, const char *src) {
+    while(*src) {
+        *dest++ = toupper((unsigned char)*src++);
+    }
+
+    *dest = '\0';
+}
+
+static void call(FILE *out, const char *indent, const char *callback) {
+    if(callback[0]) {
+        fprintf(out, "%s%s(fsm->context);\n", indent, callback);
+    }
+}
+
+static void generate_header(FILE *out) {
+    char prefix[FSMC_NAME_MAX_LEN];
+    upper(prefix, machine);
+
+    fprintf(out, "// generated by fsmc, do not edit\n\n");
+    fprintf(out, "#ifndef %s_FSM_H\n#define %s_FSM_H\n\n", prefix, prefix);
+    fprintf(out, "#include <stdbool.h>\n#include <stdint.h>\n\n");
+
+    fprintf(out, "typedef enum {\n");
+    for(int i=0; i<states_num; i++) {
+        fprintf(out, "    %s_%s = %d,\n", prefix, states[i].name, i);
+    }
+    fprintf(out, "} %s_state_t;\n\n", machine);
+
+    fprintf(out, "typedef struct {\n    void *context;\n\n    %s_state_t current;\n} %s_t;\n\n", machine, machine);
+
+    fprintf(out, "void %s_start(%s_t *fsm, %s_state_t initial);\n", machine, machine, machine);
+    fprintf(out, "bool %s_update(%s_t *fsm);\n", machine, machine);
+    fprintf(out, "void %s_execute(%s_t *fsm);\n\n", machine, machine);
+
+    fprintf(out, "#endif\n");
+}
+
+static void generate_source(FILE *out, const char *header) {
+    char prefix[FSMC_NAME_MAX_LEN];
+    upper(prefix, machine);
+
+    const char *base = strrchr(header, '/');
+    base = base ? base + 1 : header;
+
+    fprintf(out, "// generated by fsmc, do not edit\n\n");
+    fprintf(out, "#include \"%s\"\n\n", base);
+
+    // callbacks are plain functions, calls below are direct
+    for(int i=0; i<callbacks_num; i++) {
+        fprintf(out, callbacks[i].trigger ? "bool %s(const void *);\n" : "void %s(void *);\n", callbacks[i].name);
+    }
+
+    fprintf(out, "\nvoid %s_start(%s_t *fsm, %s_state_t initial) {\n", machine, machine, machine);
+    fprintf(out, "    fsm->current = initial;\n\n    switch(initial) {\n");
+    for(int i=0; i<states_num; i++) {
+        fprintf(out, "        case %s_%s:\n", prefix, states[i].name);
+        call(out, "            ", states[i].enter);
+        fprintf(out, "            break;\n");
+    }
+    fprintf(out, "    }\n}\n");
+
+    // true when a transition was taken, like fsm_update()
+    fprintf(out, "\nbool %s_update(%s_t *fsm) {\n    switch(fsm->current) {\n", machine, machine);
+    for(int i=0; i<states_num; i++) {
+        fprintf(out, "        case %s_%s:\n", prefix, states[i].name);
+
+        for(int j=0; j<transitions_num; j++) {
+            const struct fsmc_transition *transition = &transitions[j];
+
+            if(transition->from!=i) {
+                continue;
+            }
+
+            const char *indent = "            ";
+
+            if(transition->trigger[0]) {
+                fprintf(out, "            if(%s(fsm->context)) {\n", transition->trigger);
+                indent = "                ";
+            }
+
+            call(out, indent, states[i].exit);
+            call(out, indent, transition->action);
+            fprintf(out, "%sfsm->current = %s_%s;\n", indent, prefix, states[transition->to].name);
+            call(out, indent, states[transition->to].enter);
+            fprintf(out, "%sreturn true;\n", indent);
+
+            if(!transition->trigger[0]) {
+                // unconditional, following transitions are unreachable
+                break;
+            }
+
+            fprintf(out, "            }\n");
+        }
+
+        fprintf(out, "            break;\n");
+    }
+    fprintf(out, "    }\n\n    return false;\n}\n");
+
+    fprintf(out, "\nvoid %s_execute(%s_t *fsm) {\n    switch(fsm->current) {\n", machine, machine);
+    for(int i=0; i<states_num; i++) {
+        fprintf(out, "        case %s_%s:\n", prefix, states[i].name);
+        call(out, "            ", states[i].execute);
+        fprintf(out, "            break;\n");
+    }
+    fprintf(out, "    }\n}\n");
+}
+
+int main(int argc, char **argv) {
+    if(argc!=4) {
+        fprintf(stderr, "usage: %s <description> <output.c> <output.h>\n", argv[0]);
+        return 1;
+    }
+
+    path = argv[1];
+
+    FILE *input = fopen(path, "r");
+    if(!input) {
+        perror(path);
+        return 1;
+    }
+
+    parse(input);
+    fclose(input);
+
+    FILE *source = fopen(argv[2], "w");
+    if(!source) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    FILE *header = fopen(argv[3], "w");
+    if(!header) {
+        perror(argv[3]);
+        return 1;
+    }
+
+    generate_source(source, argv[3]);
+    generate_header(header);
+
+    fclose(source);
+    fclose(header);
+
+    return 0;
+}